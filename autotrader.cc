@@ -26,55 +26,74 @@
 /*----------------------------------------------------------------------------*/
 
 #include "autotrader.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
 #include <boost/asio/io_context.hpp>
+#include <ready_trader_go/bookfeatures.h>
+#include <ready_trader_go/clock.h>
+#include <ready_trader_go/error.h>
 #include <ready_trader_go/logging.h>
+#include <ready_trader_go/price.h>
 
 using namespace ReadyTraderGo;
 
 RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_AT, "AUTO")
 
-constexpr int LOT_SIZE = 200;
-constexpr int UNLOAD = 25;
-constexpr int BASELINE_SIZE = 9;
-constexpr int POSITION_LIMIT = 100;
-constexpr int CONVERSION_LINE_SIZE = 10;
-constexpr int TICK_SIZE_IN_CENTS = 100;
-constexpr int MIN_BID_NEAREST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
-constexpr int MAX_ASK_NEAREST_TICK = MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
-
 /*----------------------------------------------------------------------------*/
 
-enum class IchimokuSignal
+void AutoTraderParameters::readFromPropertyTree(const boost::property_tree::ptree &tree)
 {
-  BUY,
-  SELL,
-  NEUTRAL
-};
-
-int conversion_line_size = 9;
-int baseline_size = 26;
-int leading_span_b_window = 52;
-
-// Declare circular buffers and sums for indicators
-std::vector<unsigned long> conversionLineBuffer(conversion_line_size);
-std::vector<unsigned long> baselineBuffer(baseline_size);
-std::vector<unsigned long> leadingSpanBBuffer(leading_span_b_window);
-std::vector<unsigned long> laggingSpanBuffer(baseline_size);
-unsigned long conversionLineSum = 0;
-unsigned long baselineSum = 0;
-unsigned long leadingSpanBSum = 0;
-int conversionLineIndex = 0;
-int baselineIndex = 0;
-int leadingSpanBIndex = 0;
-int laggingSpanIndex = 0;
-int conversionLineCount = 0;
-int baselineCount = 0;
-int leadingSpanBCount = 0;
-int laggingSpanCount = 0;
+  mLotSize = tree.get<int>("LotSize", mLotSize);
+  mUnload = tree.get<int>("Unload", mUnload);
+  mPositionLimit = tree.get<int>("PositionLimit", mPositionLimit);
+  mLadderLevels = tree.get<int>("LadderLevels", mLadderLevels);
+  mConversionLineSize = tree.get<int>("ConversionLineSize", mConversionLineSize);
+  mBaselineSize = tree.get<int>("BaselineSize", mBaselineSize);
+  mLeadingSpanBWindow = tree.get<int>("LeadingSpanBWindow", mLeadingSpanBWindow);
+  mBarInterval = std::chrono::milliseconds(tree.get<long>("BarInterval", mBarInterval.count()));
+  mStaleBookAge = std::chrono::milliseconds(tree.get<long>("StaleBookAge", mStaleBookAge.count()));
+}
+
+bool AutoTraderParameters::IsParameterName(const std::string &name)
+{
+  static const std::array<const char *, 9> names = {"LotSize", "Unload", "PositionLimit", "LadderLevels",
+                                                    "ConversionLineSize", "BaselineSize", "LeadingSpanBWindow",
+                                                    "BarInterval", "StaleBookAge"};
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
 
 /*----------------------------------------------------------------------------*/
 
-AutoTrader::AutoTrader(boost::asio::io_context &context) : BaseAutoTrader(context) {}
+static void CheckParameter(const char *name, long value, long lowest, long highest)
+{
+  if (value < lowest || value > highest)
+  {
+    throw ReadyTraderGoError(std::string(name) + " must be between " + std::to_string(lowest) + " and "
+                             + std::to_string(highest) + ", not " + std::to_string(value));
+  }
+}
+
+AutoTrader::AutoTrader(boost::asio::io_context &context, const AutoTraderParameters &parameters)
+    : BaseAutoTrader(context), mParameters(parameters), mFutureBars(parameters.mBarInterval), mQuotes(*this),
+      mHedger(*this, context)
+{
+  CheckParameter("LotSize", mParameters.mLotSize, 1, std::numeric_limits<int>::max());
+  CheckParameter("Unload", mParameters.mUnload, 0, std::numeric_limits<int>::max());
+  CheckParameter("PositionLimit", mParameters.mPositionLimit, 0, std::numeric_limits<int>::max());
+  CheckParameter("LadderLevels", mParameters.mLadderLevels, 1, MAX_LADDER_LEVELS);
+  CheckParameter("ConversionLineSize", mParameters.mConversionLineSize, 1, MAX_ICHIMOKU_WINDOW);
+  // The lagging span needs one bar more than the baseline.
+  CheckParameter("BaselineSize", mParameters.mBaselineSize, 1, MAX_ICHIMOKU_WINDOW - 1);
+  CheckParameter("LeadingSpanBWindow", mParameters.mLeadingSpanBWindow, 1, MAX_ICHIMOKU_WINDOW);
+  CheckParameter("BarInterval", mParameters.mBarInterval.count(), 1, 3600000);
+  CheckParameter("StaleBookAge", mParameters.mStaleBookAge.count(), 0, 3600000);
+
+  mHot.conversionLineSize = mParameters.mConversionLineSize;
+  mHot.baselineSize = mParameters.mBaselineSize;
+  mHot.leadingSpanBWindow = mParameters.mLeadingSpanBWindow;
+}
 
 /*----------------------------------------------------------------------------*/
 
@@ -89,13 +108,8 @@ void AutoTrader::DisconnectHandler()
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string &errorMessage)
 {
-  ;
   RLOG(LG_AT, LogLevel::LL_INFO) << "error with order " << clientOrderId << ": " << errorMessage;
-  if (clientOrderId != 0 && ((mAsks.count(clientOrderId) == 1) ||
-                             (mBids.count(clientOrderId) == 1)))
-  {
-    OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
-  }
+  mHedger.OnError(clientOrderId);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -105,62 +119,63 @@ void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long volume)
 {
   RLOG(LG_AT, LogLevel::LL_INFO) << "hedge order " << clientOrderId << " filled for " << volume << " lots at $" << price << " average price in cents";
+  mHedger.OnHedgeFilled(clientOrderId, price, volume);
+  mHot.mHedges = mHedger.FuturePosition();
+  Publish(GetMetrics().mFuturePosition, mHot.mHedges);
 }
 
 /*----------------------------------------------------------------------------*/
 
-void AutoTrader::updateCircularBufferWithNewValue(std::vector<unsigned long> &buffer, int &index, int &count, unsigned long newValue, unsigned long &sum, int maxSize)
+// The midpoint of the highest high and lowest low over the last `window`
+// bars (or as many as there have been).
+unsigned long AutoTrader::IchimokuMidpoint(int window) const
 {
-  if (count < maxSize)
+  const int count = std::min(window, mHot.barCount);
+  unsigned long highest = 0;
+  unsigned long lowest = MAXIMUM_ASK;
+  for (int i = 1; i <= count; ++i)
   {
-    buffer[index] = newValue;
-    sum += newValue;
-    count++;
+    const int slot = (mHot.barIndex - i + MAX_ICHIMOKU_WINDOW) % MAX_ICHIMOKU_WINDOW;
+    highest = std::max(highest, mHot.highBuffer[slot]);
+    lowest = std::min(lowest, mHot.lowBuffer[slot]);
   }
-  else
-  {
-    sum -= buffer[index];
-    buffer[index] = newValue;
-    sum += newValue;
-  }
-  index = (index + 1) % maxSize;
+  return (highest + lowest) >> 1;
 }
 
 /*----------------------------------------------------------------------------*/
 
-AutoTrader::IchimokuSignal AutoTrader::Ichimoku(const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> &askPrices,
-                                                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> &askVolumes,
-                                                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> &bidPrices,
-                                                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> &bidVolumes)
+AutoTrader::IchimokuSignal AutoTrader::Ichimoku(const Bar &bar)
 {
-  unsigned long currentPrice = (bidPrices[0] + askPrices[0]) >> 1;
-
-  // Conversion Line calculation
-  updateCircularBufferWithNewValue(conversionLineBuffer, conversionLineIndex, conversionLineCount, currentPrice, conversionLineSum, conversion_line_size);
-  unsigned long conversionLine = conversionLineSum / conversionLineCount;
-
-  // Base Line calculation
-  updateCircularBufferWithNewValue(baselineBuffer, baselineIndex, baselineCount, conversionLine, baselineSum, baseline_size);
-  unsigned long baseline = baselineSum / baselineCount;
-
-  // Leading Span A calculation
-  unsigned long leadingSpanA = (conversionLine + baseline) >> 1;
-
-  // Leading Span B calculation
-  updateCircularBufferWithNewValue(leadingSpanBBuffer, leadingSpanBIndex, leadingSpanBCount, conversionLine, leadingSpanBSum, leading_span_b_window);
-  unsigned long leadingSpanB = (leadingSpanBSum + baseline) >> 1;
-
-  // Lagging Span (Chikou Span) calculation
-  updateCircularBufferWithNewValue(laggingSpanBuffer, laggingSpanIndex, laggingSpanCount, currentPrice, leadingSpanBSum, baseline_size);
-  unsigned long laggingSpan = laggingSpanBuffer[laggingSpanIndex];
+  mHot.highBuffer[mHot.barIndex] = bar.mHigh;
+  mHot.lowBuffer[mHot.barIndex] = bar.mLow;
+  mHot.closeBuffer[mHot.barIndex] = bar.mClose;
+  mHot.barIndex = (mHot.barIndex + 1) % MAX_ICHIMOKU_WINDOW;
+  mHot.barCount = std::min(mHot.barCount + 1, MAX_ICHIMOKU_WINDOW);
+
+  const unsigned long currentPrice = bar.mClose;
+
+  // Conversion Line, Base Line and Leading Span B are midpoints of the
+  // period high and low over their windows
+  const unsigned long conversionLine = IchimokuMidpoint(mHot.conversionLineSize);
+  const unsigned long baseline = IchimokuMidpoint(mHot.baselineSize);
+  const unsigned long leadingSpanA = (conversionLine + baseline) >> 1;
+  const unsigned long leadingSpanB = IchimokuMidpoint(mHot.leadingSpanBWindow);
+
+  // Lagging Span (Chikou Span): today's close against the close a baseline ago
+  if (mHot.barCount <= mHot.baselineSize)
+  {
+    return IchimokuSignal::NEUTRAL;
+  }
+  const int laggingSlot = (mHot.barIndex - 1 - mHot.baselineSize + MAX_ICHIMOKU_WINDOW) % MAX_ICHIMOKU_WINDOW;
+  const unsigned long laggingPrice = mHot.closeBuffer[laggingSlot];
 
   // Trading strategy
   bool priceAboveCloud = currentPrice > std::min(leadingSpanA, leadingSpanB);
   bool priceBelowCloud = currentPrice < std::max(leadingSpanA, leadingSpanB);
   bool priceAboveConversionAndBase = currentPrice > conversionLine && currentPrice > baseline;
   bool priceBelowConversionAndBase = currentPrice < conversionLine && currentPrice < baseline;
-  bool laggingSpanAbovePrice = laggingSpan > laggingSpanBuffer[(laggingSpanIndex - baseline_size + laggingSpanBuffer.size()) % laggingSpanBuffer.size()];
-  bool laggingSpanBelowPrice = laggingSpan < laggingSpanBuffer[(laggingSpanIndex - baseline_size + laggingSpanBuffer.size()) % laggingSpanBuffer.size()];
+  bool laggingSpanAbovePrice = currentPrice > laggingPrice;
+  bool laggingSpanBelowPrice = currentPrice < laggingPrice;
 
   // Initialize ICHIMOKU as 'no signal'
   IchimokuSignal signal = IchimokuSignal::NEUTRAL;
@@ -183,33 +198,96 @@ AutoTrader::IchimokuSignal AutoTrader::Ichimoku(const std::array<unsigned long,
 
 /*----------------------------------------------------------------------------*/
 
-static double WeightedAverageSpread(const std::array<unsigned long, TOP_LEVEL_COUNT> &askPrices,
-                                    const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
-                                    const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
-                                    const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes)
+// Indicators built on bars are only updated here, once per bar.
+void AutoTrader::FutureBarCompleted(const Bar &bar)
 {
-  double totalSpreadVolume = 0.0;
-  double weightedSpreadSum = 0.0;
+  RLOG(LG_AT, LogLevel::LL_INFO) << "future bar: open " << bar.mOpen << " high " << bar.mHigh << " low " << bar.mLow
+                                 << " close " << bar.mClose << " volume " << bar.mVolume << " vwap " << bar.Vwap()
+                                 << " flow " << bar.mFlow;
+  mHot.signal = Ichimoku(bar);
+}
 
-  for (int i = 0; i < TOP_LEVEL_COUNT; ++i)
+/*----------------------------------------------------------------------------*/
+
+// Spreads a side's quantity over the configured number of prices one tick
+// apart, moving away from the touch. Any odd lots go on the best level.
+// Levels that would fall outside the valid price range are dropped.
+Ladder AutoTrader::BuildLadder(Side side, Price bestPrice, Volume quantity) const
+{
+  Ladder ladder;
+  if (!bestPrice.IsValid())
   {
-    if (askPrices[i] != 0 && bidPrices[i] != 0)
+    return ladder;
+  }
+
+  const unsigned long tickSize = GetExchangeLimits().mTickSize;
+  const int levels = mParameters.mLadderLevels;
+  const Volume perLevel = quantity / levels;
+  const PriceDelta step = PriceDelta::Ticks((side == Side::SELL) ? 1 : -1, tickSize);
+  Price previous;
+  for (int i = 0; i < levels; ++i)
+  {
+    Price price = bestPrice + PriceDelta(step.Cents() * i);
+    price = (side == Side::SELL) ? price.RoundDown(tickSize) : price.RoundUp(tickSize);
+    if (price == previous)
     {
-      double spread = (askPrices[i] - bidPrices[i]) >> 1;
-      double spreadVolume = std::min(askVolumes[i], bidVolumes[i]);
-      totalSpreadVolume += spreadVolume;
-      weightedSpreadSum += spread * spreadVolume;
+      // Saturated at the edge of the valid price range.
+      break;
     }
+    const Volume volume = (i == 0) ? quantity - perLevel * (levels - 1) : perLevel;
+    ladder.Add(price.Cents(), volume.Lots());
+    previous = price;
   }
+  return ladder;
+}
 
-  if (totalSpreadVolume > 0.0)
+/*----------------------------------------------------------------------------*/
+
+void AutoTrader::UpdateQuoteTargets()
+{
+  // Quote around the fair value rather than the future's touch: the half
+  // spread comes from the future book, as before, plus the weighted average
+  // spread and the inventory skew.
+  const unsigned long tickSize = GetExchangeLimits().mTickSize;
+  const Price fairPrice(mFairValue.FairPrice());
+  const PriceDelta halfSpread(static_cast<signed long>(mFairValue.Spread(Instrument::FUTURE) / 2));
+  const PriceDelta skew = PriceDelta::Ticks(-(mHot.mPosition / mParameters.mLotSize), tickSize);
+  Price newAskPrice = (fairPrice + halfSpread + skew + mHot.mWeightedSpread).RoundDown(tickSize);
+  Price newBidPrice = (fairPrice - halfSpread + skew - mHot.mWeightedSpread).RoundDown(tickSize);
+
+  // Lean a side a tick towards the fair value when the Ichimoku signal
+  // favours it, or when the position is past the unload threshold and there
+  // are lots in profit that it would unwind, as long as the two sides still
+  // do not meet.
+  bool leanAsk = mHot.signal == IchimokuSignal::SELL;
+  bool leanBid = mHot.signal == IchimokuSignal::BUY;
+  if (mHot.mPosition >= mParameters.mUnload || mHot.mPosition <= -mParameters.mUnload)
   {
-    return weightedSpreadSum / totalSpreadVolume;
+    const unsigned long currentPrice = fairPrice.Cents();
+    mLots.ForEach([&](const OrderRecord &lot) {
+      leanAsk = leanAsk || (lot.mSide == Side::BUY && lot.CostBasis() < currentPrice);
+      leanBid = leanBid || (lot.mSide == Side::SELL && lot.CostBasis() > currentPrice);
+    });
   }
-  else
+  const PriceDelta tick = PriceDelta::Ticks(1, tickSize);
+  if (leanAsk && newAskPrice - tick > newBidPrice)
   {
-    return 0.0;
+    newAskPrice = newAskPrice - tick;
   }
+  if (leanBid && newBidPrice + tick < newAskPrice)
+  {
+    newBidPrice = newBidPrice + tick;
+  }
+
+  // Each side may use half of the exchange's active volume limit.
+  const Volume sideVolumeLimit = Min(Volume(mParameters.mLotSize), Volume(GetExchangeLimits().mActiveVolumeLimit / 2));
+  const Volume askQuantity = Min(sideVolumeLimit, Volume::FromSigned(mParameters.mPositionLimit + mHot.mPosition));
+  const Volume bidQuantity = Min(sideVolumeLimit, Volume::FromSigned(mParameters.mPositionLimit - mHot.mPosition));
+
+  mAskLadder = BuildLadder(Side::SELL, newAskPrice, askQuantity);
+  mBidLadder = BuildLadder(Side::BUY, newBidPrice, bidQuantity);
+  mHot.mQuotedPosition = mHot.mPosition;
+  mHot.mQuotedSignal = mHot.signal;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -228,147 +306,47 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
                                  << "; bid prices: " << bidPrices[0]
                                  << "; bid volumes: " << bidVolumes[0];
 
-  double weightedAverageSpread = WeightedAverageSpread(askPrices, askVolumes, bidPrices, bidVolumes);
-  unsigned long priceAdjustment = -(mPosition / LOT_SIZE) * TICK_SIZE_IN_CENTS;
-  unsigned long currentPrice = (bidPrices[0] + askPrices[0]) >> 1;
-  unsigned long newAskPrice = (askPrices[0] != 0) ? askPrices[0] + priceAdjustment + weightedAverageSpread : 0;
-  unsigned long newBidPrice = (bidPrices[0] != 0) ? bidPrices[0] + priceAdjustment - weightedAverageSpread : 0;
-  newAskPrice = (newAskPrice / TICK_SIZE_IN_CENTS) * TICK_SIZE_IN_CENTS;
-  newBidPrice = (newBidPrice / TICK_SIZE_IN_CENTS) * TICK_SIZE_IN_CENTS;
-  unsigned long askQuantity = std::min<unsigned long>(LOT_SIZE, static_cast<unsigned long>(POSITION_LIMIT + mPosition));
-  unsigned long bidQuantity = std::min<unsigned long>(LOT_SIZE, static_cast<unsigned long>(POSITION_LIMIT - mPosition));
+  const bool fairValueMoved = mFairValue.Update(instrument, askPrices[0], askVolumes[0], bidPrices[0], bidVolumes[0]);
 
   if (instrument == Instrument::FUTURE)
   {
-    if (newAskPrice != 0 && newAskPrice != mAskPrice)
+    mHedger.OnFutureOrderBook(askPrices, askVolumes, bidPrices, bidVolumes);
+    ComputeBookFeatures(askPrices, askVolumes, bidPrices, bidVolumes, mFutureFeatures);
+    mHot.mWeightedSpread = mFutureFeatures.WeightedHalfSpread();
+    if (mFutureBars.OnOrderBook(Clock::now(), askPrices[0], bidPrices[0]))
     {
-      if (mAskId != 0)
-      {
-        SendCancelOrder(mAskId);
-        PendingCancelAsk = true;
-      }
-      if (!PendingCancelAsk && askQuantity > 0)
-      {
-
-        mAskId = mNextMessageId++;
-        SendInsertOrder(mAskId, Side::SELL, newAskPrice, askQuantity, Lifespan::GOOD_FOR_DAY);
-        mAsks.emplace(mAskId);
-      }
-      mAskPrice = newAskPrice;
-    }
-    if (newBidPrice != 0 && newBidPrice != mBidPrice)
-    {
-      if (mBidId != 0)
-      {
-        SendCancelOrder(mBidId);
-        PendingCancelBid = true;
-      }
-      if (!PendingCancelBid && bidQuantity > 0)
-      {
-
-        mBidId = mNextMessageId++;
-        SendInsertOrder(mBidId, Side::BUY, newBidPrice, bidQuantity, Lifespan::GOOD_FOR_DAY);
-        mBids.emplace(mBidId);
-      }
-      mBidPrice = newBidPrice;
+      FutureBarCompleted(mFutureBars.LastBar());
     }
+  }
 
-    IchimokuSignal signal = Ichimoku(askPrices, askVolumes, bidPrices, bidVolumes);
-    if (leadingSpanBBuffer.size() >= 52 && signal == IchimokuSignal::BUY)
-    {
-      // BUY SIGNAL
-      if (newBidPrice != 0 && newBidPrice != mBidPrice)
-      {
-        if (mBidId != 0)
-        {
-          SendCancelOrder(mBidId);
-          PendingCancelBid = true;
-        }
-        if (!PendingCancelBid && bidQuantity > 0)
-        {
-          mBidId = mNextMessageId++;
-          SendInsertOrder(mBidId, Side::BUY, newBidPrice, bidQuantity, Lifespan::GOOD_FOR_DAY);
-          mBids.emplace(mBidId);
-        }
-        mBidPrice = newBidPrice;
-      }
-    }
-    else if (signal == IchimokuSignal::SELL)
-    {
-      // SELL SIGNAL
-      if (newAskPrice != 0 && newAskPrice != mAskPrice)
-      {
-        if (mAskId != 0)
-        {
-          SendCancelOrder(mAskId);
-          PendingCancelAsk = true;
-        }
-        if (!PendingCancelAsk && askQuantity > 0)
-        {
-          mAskId = mNextMessageId++;
-          SendInsertOrder(mAskId, Side::SELL, newAskPrice, askQuantity, Lifespan::GOOD_FOR_DAY);
-          mAsks.emplace(mAskId);
-        }
-        mAskPrice = newAskPrice;
-      }
-    }
+  if (mFairValue.FairPrice() == 0)
+  {
+    return;
+  }
 
-    // Check if the position is outside of the unload range
-    if (mPosition >= UNLOAD || mPosition <= -UNLOAD)
-    {
-      // Check profit-taking for each long position
-      for (const auto &[longId, longCostBasis] : longInventory)
-      {
-        if (newAskPrice != 0 && newAskPrice != mAskPrice)
-        {
-
-          // Check profit-taking for long position
-          if (longCostBasis < currentPrice)
-          {
-            if (newAskPrice != 0 && newAskPrice != mAskPrice)
-            {
-              if (mAskId != 0)
-              {
-                SendCancelOrder(mAskId);
-                PendingCancelAsk = true;
-              }
-              if (!PendingCancelAsk && askQuantity > 0)
-              {
-                mAskId = mNextMessageId++;
-                SendInsertOrder(mAskId, Side::SELL, newAskPrice, askQuantity, Lifespan::GOOD_FOR_DAY);
-                mAsks.emplace(mAskId);
-              }
-              mAskPrice = newAskPrice;
-            }
-          }
-        }
-      }
-      // Check profit-taking for each short position
-      for (const auto &[shortId, shortCostBasis] : shortInventory)
-      {
-        // Check profit-taking for short position
-        if (shortCostBasis > currentPrice)
-        {
-          // Place new bid order if none exist and new bid price is valid
-          if (newBidPrice != 0 && newBidPrice != mBidPrice)
-          {
-            if (mBidId != 0)
-            {
-              SendCancelOrder(mBidId);
-              PendingCancelBid = true;
-            }
-            if (!PendingCancelBid && bidQuantity > 0)
-            {
-              mBidId = mNextMessageId++;
-              SendInsertOrder(mBidId, Side::BUY, newBidPrice, bidQuantity, Lifespan::GOOD_FOR_DAY);
-              mBids.emplace(mBidId);
-            }
-            mBidPrice = newBidPrice;
-          }
-        }
-      }
-    }
+  // Both books are published on every tick, so if the other one has not
+  // been seen for a while the fair value is built on stale prices and the
+  // quotes come out until it turns up again.
+  const Instrument other = (instrument == Instrument::FUTURE) ? Instrument::ETF : Instrument::FUTURE;
+  if (BookAge(other) > mParameters.mStaleBookAge)
+  {
+    RLOG(LG_AT, LogLevel::LL_WARNING) << other << " order book is stale, pulling quotes";
+    mQuotes.Update(Side::SELL, Ladder{});
+    mQuotes.Update(Side::BUY, Ladder{});
+    return;
+  }
+
+  // The targets only change when the fair value moves by a tick, the
+  // position changes or a new bar changes the signal. The ladder is still
+  // brought into line on every update, which costs nothing when it already
+  // is, so that levels waiting on a cancel or on message budget go in
+  // promptly.
+  if (fairValueMoved || mHot.mPosition != mHot.mQuotedPosition || mHot.signal != mHot.mQuotedSignal)
+  {
+    UpdateQuoteTargets();
   }
+  mQuotes.Update(Side::SELL, mAskLadder);
+  mQuotes.Update(Side::BUY, mBidLadder);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -377,27 +355,39 @@ void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume)
 {
-  if (mAsks.count(clientOrderId) == 1)
+  const OrderRecord *order = GetOrderManager().Find(clientOrderId);
+  if (order == nullptr)
   {
-    long newPosition = mPosition - static_cast<long>(volume);
-    if (std::abs(newPosition + mHedges) <= POSITION_LIMIT && std::abs(newPosition) <= POSITION_LIMIT)
-    {
-      mPosition = newPosition;
-    }
-    SendHedgeOrder(mNextMessageId++, Side::BUY, MAX_ASK_NEAREST_TICK, volume);
-    shortInventory.emplace(clientOrderId, price);
+    return;
+  }
+
+  // The order manager has already applied this fill, so its position is
+  // the one the exchange holds.
+  mHot.mPosition = GetOrderManager().Position();
+  mHedger.OnOrderFilled();
+
+  OrderRecord *lot = mLots.Find(clientOrderId);
+  if (lot == nullptr)
+  {
+    lot = mLots.Insert(clientOrderId, order->mSide, order->mPrice, order->mVolume);
   }
-  else if (mBids.count(clientOrderId) == 1)
+  if (lot == nullptr)
   {
-    long newPosition = mPosition + static_cast<long>(volume);
-    if (std::abs(newPosition - mHedges) <= POSITION_LIMIT && std::abs(newPosition) <= POSITION_LIMIT)
-    {
-      mPosition = newPosition;
-    }
-    SendHedgeOrder(mNextMessageId++, Side::SELL, MIN_BID_NEAREST_TICK, volume);
-    longInventory.emplace(clientOrderId, price);
+    // The lot's slot still holds an older lot that has not finished. The fill
+    // still counts towards the position, but profit taking will not unwind
+    // it lot by lot.
+    return;
+  }
+  lot->mFilledVolume += volume;
+  lot->mFilledValue += price * volume;
+  lot->mRemainingVolume = order->mRemainingVolume;
+
+  // Once flat, the lots that built the old position no longer need to be
+  // unwound, so their records can go.
+  if (mHot.mPosition == 0)
+  {
+    mLots.RetireIf([](const OrderRecord &old) { return old.mState == OrderState::DONE; });
   }
-  lotSize.emplace(clientOrderId, volume);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -407,35 +397,15 @@ void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
                                            unsigned long remainingVolume,
                                            signed long fees)
 {
-  if (remainingVolume == 0)
+  if (OrderRecord *lot = mLots.Find(clientOrderId))
   {
-    if (clientOrderId == mAskId)
+    lot->mRemainingVolume = remainingVolume;
+    lot->mFees = fees;
+    if (remainingVolume == 0)
     {
-      mAskId = 0;
-      PendingCancelAsk = false;
-    }
-    else if (clientOrderId == mBidId)
-    {
-      mBidId = 0;
-      PendingCancelBid = false;
-    }
-
-    // Remove from mAsks and mBids only if they exist there
-    if (mAsks.count(clientOrderId) == 1)
-    {
-      mAsks.erase(clientOrderId);
-    }
-    if (mBids.count(clientOrderId) == 1)
-    {
-      mBids.erase(clientOrderId);
+      lot->mState = OrderState::DONE;
     }
   }
-  else
-  {
-    longInventory[clientOrderId] += fees;
-    shortInventory[clientOrderId] -= fees;
-    lotSize[clientOrderId] = remainingVolume;
-  }
 }
 
 /*----------------------------------------------------------------------------*/
@@ -452,6 +422,12 @@ void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
                                  << "; ask volumes: " << askVolumes[0]
                                  << "; bid prices: " << bidPrices[0]
                                  << "; bid volumes: " << bidVolumes[0];
+
+  if (instrument == Instrument::FUTURE
+      && mFutureBars.OnTradeTicks(Clock::now(), askPrices, askVolumes, bidPrices, bidVolumes))
+  {
+    FutureBarCompleted(mFutureBars.LastBar());
+  }
 }
 
 
@@ -29,19 +29,54 @@
 #define CPPREADY_TRADER_GO_AUTOTRADER_H
 
 #include <array>
-#include <vector>
+#include <chrono>
 #include <memory>
 #include <string>
-#include <unordered_set>
-#include <unordered_map>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/property_tree/ptree.hpp>
 
+#include <ready_trader_go/barbuilder.h>
 #include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/bookfeatures.h>
+#include <ready_trader_go/fairvalue.h>
+#include <ready_trader_go/hedgemanager.h>
+#include <ready_trader_go/orderregistry.h>
+#include <ready_trader_go/price.h>
+#include <ready_trader_go/quoteladder.h>
 #include <ready_trader_go/types.h>
 
 /*----------------------------------------------------------------------------*/
 
+/**
+
+@brief: The strategy's tunable constants. The defaults are the values the
+strategy was hand-tuned to; readFromPropertyTree overrides any that are
+given (durations are in milliseconds). The AutoTrader constructor throws a
+ReadyTraderGoError if any is out of range.
+*/
+struct AutoTraderParameters
+{
+    void readFromPropertyTree(const boost::property_tree::ptree &tree);
+
+    // True if readFromPropertyTree reads a parameter of this name.
+    static bool IsParameterName(const std::string &name);
+
+    // A LotSize above min(PositionLimit, ActiveVolumeLimit / 2) has no effect:
+    // the side volume is capped there, and the skew never reaches a tick.
+    int mLotSize = 200;                                  // Most lots quoted on a side; also scales the skew.
+    int mUnload = 25;                                    // Position at which profitable lots are unwound.
+    int mPositionLimit = 100;
+    int mLadderLevels = 3;                               // Prices a side's quantity is spread over.
+    int mConversionLineSize = 9;                         // Ichimoku windows, in bars.
+    int mBaselineSize = 26;
+    int mLeadingSpanBWindow = 52;
+    std::chrono::milliseconds mBarInterval{1000};
+    std::chrono::milliseconds mStaleBookAge{500};
+};
+
+/*----------------------------------------------------------------------------*/
+
 class AutoTrader : public ReadyTraderGo::BaseAutoTrader
 {
 public:
@@ -53,8 +88,10 @@ public:
 
     @param: `context` The boost::asio::io_context object to use
     for asynchronous operations.
+    @param: `parameters` The strategy's constants.
     */
-    explicit AutoTrader(boost::asio::io_context &context);
+    explicit AutoTrader(boost::asio::io_context &context,
+                        const AutoTraderParameters &parameters = AutoTraderParameters());
 
     /*------------------------------------------------------------------------*/
 
@@ -115,10 +152,10 @@ public:
     @param: bidVolumes The array of bid volumes for the top levels of the order book.
 
     Called periodically to report the status of an order book.
-    The sequence number can be used to detect missed or out-of-order
-    messages. The five best available ask (i.e. sell) and bid (i.e. buy)
-    prices are reported along with the volume available at each of those
-    price levels.
+    Duplicate and out-of-order messages have already been dropped, and
+    gaps counted, by the base class's sequence tracking. The five best
+    available ask (i.e. sell) and bid (i.e. buy) prices are reported
+    along with the volume available at each of those price levels.
     */
     void OrderBookMessageHandler(ReadyTraderGo::Instrument instrument,
                                  unsigned long sequenceNumber,
@@ -200,27 +237,57 @@ private:
         SELL,
         NEUTRAL
     };
-    using PriceVolumeArray = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
-    IchimokuSignal Ichimoku(const PriceVolumeArray &askPrices,
-                         const PriceVolumeArray &askVolumes,
-                         const PriceVolumeArray &bidPrices,
-                         const PriceVolumeArray &bidVolumes);
-    void updateCircularBufferWithNewValue(std::vector<unsigned long> &buffer, int &index, int &count, unsigned long newValue, unsigned long &sum, int maxSize);
-
-    unsigned long mNextMessageId = 1;                                // The next message id to use
-    unsigned long mAskId = 0;                                        // The current ask order id.
-    unsigned long mBidId = 0;                                        // The current bid order id.
-    unsigned long mAskPrice = 0;                                     // The current ask price.
-    unsigned long mBidPrice = 0;                                     // The current bid price.
-    signed long mPosition = 0;                                       // The current position (in lots).
-    signed long mHedges = 0;                                         // The number of hedges (in lots).
-    std::unordered_set<unsigned long> mAsks;                         // A set of active ask order ids.
-    std::unordered_set<unsigned long> mBids;                         // A set of active bid order ids.
-    std::unordered_map<unsigned long, unsigned long> shortInventory; // maps id and cost
-    std::unordered_map<unsigned long, unsigned long> longInventory;  // maps id and cost
-    std::unordered_map<unsigned long, unsigned long> lotSize;        // maps id and size
-    bool PendingCancelAsk = false;
-    bool PendingCancelBid = false;
+
+    // Capacity of the Ichimoku bar history; the active window sizes are
+    // per-instance and may be anything up to this (the lagging span needs
+    // one more bar than the baseline).
+    static constexpr int MAX_ICHIMOKU_WINDOW = 64;
+
+    /**
+
+    @brief: Per-instance strategy state that is touched on every update.
+    The scalars come first so that the quoting decision only needs the first
+    cache line or two; the rolling windows follow. Keeping all of it inside
+    the instance means several AutoTraders can share one process.
+    */
+    struct alignas(64) HotState
+    {
+        signed long mPosition = 0;                                       // The current position (in lots).
+        signed long mHedges = 0;                                         // The future position from hedges (in lots).
+        signed long mQuotedPosition = 0;                                 // The position the quote targets were built for.
+        IchimokuSignal mQuotedSignal = IchimokuSignal::NEUTRAL;          // The signal they were built for.
+        ReadyTraderGo::PriceDelta mWeightedSpread;                       // From the latest future order book.
+
+        int conversionLineSize = 0;
+        int baselineSize = 0;
+        int leadingSpanBWindow = 0;
+
+        IchimokuSignal signal = IchimokuSignal::NEUTRAL;                 // As of the last completed future bar.
+        int barIndex = 0;
+        int barCount = 0;
+
+        std::array<unsigned long, MAX_ICHIMOKU_WINDOW> highBuffer = {};
+        std::array<unsigned long, MAX_ICHIMOKU_WINDOW> lowBuffer = {};
+        std::array<unsigned long, MAX_ICHIMOKU_WINDOW> closeBuffer = {};
+    };
+
+    void FutureBarCompleted(const ReadyTraderGo::Bar &bar);
+    IchimokuSignal Ichimoku(const ReadyTraderGo::Bar &bar);
+    unsigned long IchimokuMidpoint(int window) const;
+    ReadyTraderGo::Ladder BuildLadder(ReadyTraderGo::Side side, ReadyTraderGo::Price bestPrice,
+                                      ReadyTraderGo::Volume quantity) const;
+    void UpdateQuoteTargets();
+
+    HotState mHot;
+    const AutoTraderParameters mParameters;
+    ReadyTraderGo::FairValue mFairValue;                             // ETF fair value from both books.
+    ReadyTraderGo::BookFeatures mFutureFeatures;                     // From the latest future order book.
+    ReadyTraderGo::BarBuilder mFutureBars;                           // Bars that drive the Ichimoku signal.
+    ReadyTraderGo::Ladder mAskLadder;                                // The asks we want resting.
+    ReadyTraderGo::Ladder mBidLadder;                                // The bids we want resting.
+    ReadyTraderGo::QuoteLadder mQuotes;                              // Keeps our bid and ask ladders in line.
+    ReadyTraderGo::OrderRegistry mLots;                              // Filled lots not yet unwound.
+    ReadyTraderGo::HedgeManager mHedger;                             // Keeps the future position in line.
 };
 
 #endif // CPPREADY_TRADER_GO_AUTOTRADER_H
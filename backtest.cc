@@ -0,0 +1,147 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/config.h>
+#include <ready_trader_go/error.h>
+#include <simulator/backtest.h>
+#include <simulator/marketdata.h>
+#include <simulator/marketdatafile.h>
+#include <simulator/toolsupport.h>
+
+#include "autotrader.h"
+
+// Runs the AutoTrader over a market data file in-process and prints how it
+// did. Takes the exchange configuration (for the market data file, fees and
+// limits), the autotrader configuration (for its name and limits) and,
+// optionally, a market data file to use instead. Strategy parameters (see
+// AutoTraderParameters) are taken from the autotrader configuration's
+// Strategy section, if it has one:
+//
+//     backtest [exchange.json] [autotrader.json] [market_data.csv]
+//
+// A market data file that does not end in .csv is taken to be one made by
+// mdconvert, which is mapped rather than parsed.
+//
+// One-way latencies between the exchange and the AutoTrader are taken from
+// the exchange configuration's Latency section, in seconds:
+//
+//     "Latency": { "InformationPublish": 0.0001, "OrderEntry": 0.00005,
+//                  "ExecutionReport": 0.00005 }
+//
+// Logging is switched off, as it would otherwise take most of the time.
+int main(int argc, char* argv[])
+{
+    boost::property_tree::ptree exchangeTree;
+    boost::property_tree::ptree traderTree;
+    if (!ReadyTraderGo::ReadJsonFile((argc > 1) ? argv[1] : "exchange.json", exchangeTree)
+        || !ReadyTraderGo::ReadJsonFile((argc > 2) ? argv[2] : "autotrader.json", traderTree))
+    {
+        return EXIT_FAILURE;
+    }
+
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        ReadyTraderGo::SimulatorConfig simulatorConfig;
+        simulatorConfig.readFromPropertyTree(exchangeTree);
+        if (argc > 3)
+        {
+            simulatorConfig.mMarketDataFile = argv[3];
+        }
+
+        ReadyTraderGo::Config traderConfig;
+        traderConfig.readFromPropertyTree(traderTree);
+        AutoTraderParameters parameters;
+        parameters.readFromPropertyTree(traderTree.get_child("Strategy", {}));
+
+        const auto loadStart = std::chrono::steady_clock::now();
+        const std::string& filename = simulatorConfig.mMarketDataFile;
+        std::vector<ReadyTraderGo::MarketEvent> csvEvents;
+        std::unique_ptr<ReadyTraderGo::MarketDataFile> mappedEvents;
+        std::unique_ptr<ReadyTraderGo::MarketEventSource> events;
+        if (ReadyTraderGo::IsMarketDataCsv(filename))
+        {
+            csvEvents = ReadyTraderGo::ReadMarketDataCsv(filename);
+            events = std::make_unique<ReadyTraderGo::MarketEventVectorSource>(csvEvents);
+        }
+        else
+        {
+            mappedEvents = std::make_unique<ReadyTraderGo::MarketDataFile>(filename);
+            events = std::make_unique<ReadyTraderGo::MarketDataFile::Cursor>(mappedEvents->Events());
+        }
+        const auto runStart = std::chrono::steady_clock::now();
+
+        ReadyTraderGo::Backtest backtest{simulatorConfig, *events};
+        boost::asio::io_context context;
+        AutoTrader trader{context, parameters};
+        trader.SetLoginDetails(traderConfig.mTeamName, traderConfig.mSecret);
+        trader.SetExchangeLimits(traderConfig.mLimits);
+        const ReadyTraderGo::BacktestResult result = backtest.Run(trader, context);
+
+        const auto runEnd = std::chrono::steady_clock::now();
+        const auto milliseconds = [](auto duration) {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        };
+
+        const auto& account = result.mAccount;
+        const auto& stats = result.mStats;
+        std::cout << std::fixed << std::setprecision(2)
+                  << "market data:    " << simulatorConfig.mMarketDataFile << " (" << result.mEventsProcessed
+                  << " events, " << result.mTicks << " ticks, " << result.mEndTime << "s)\n"
+                  << "latency:        " << simulatorConfig.mInformationLatency * 1e6 << "us information, "
+                  << simulatorConfig.mOrderEntryLatency * 1e6 << "us order entry, "
+                  << simulatorConfig.mExecutionReportLatency * 1e6 << "us execution report\n"
+                  << "status:         " << result.mStatus << '\n'
+                  << "profit or loss: " << account.mProfitOrLoss / 100.0 << '\n'
+                  << "max drawdown:   " << account.mMaxDrawdown / 100.0 << '\n'
+                  << "fees:           " << account.mTotalFees / 100.0 << '\n'
+                  << "etf position:   " << account.mEtfPosition << " (max " << stats.mMaxEtfPosition << ")\n"
+                  << "fut position:   " << account.mFuturePosition << '\n'
+                  << "etf volume:     " << account.mBuyVolume << " bought, " << account.mSellVolume << " sold\n"
+                  << "messages:       " << stats.mMessagesReceived << " (" << stats.mInserts << " inserts, "
+                  << stats.mAmends << " amends, " << stats.mCancels << " cancels, " << stats.mHedges << " hedges)\n"
+                  << "fills:          " << stats.mFills << '\n'
+                  << "errors:         " << stats.mErrors << '\n'
+                  << "load time:      " << milliseconds(runStart - loadStart) << "ms\n"
+                  << "run time:       " << milliseconds(runEnd - runStart) << "ms" << std::endl;
+    }
+    catch (const boost::property_tree::ptree_error& e)
+    {
+        std::cerr << "bad configuration: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (const ReadyTraderGo::ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <ready_trader_go/bookfeatures.h>
+#include <ready_trader_go/types.h>
+
+// Times the order book feature kernel against its scalar reference and
+// against the single weighted average spread the autotrader used to compute
+// per update, and checks that the two kernels agree on every book.
+//
+// Usage: featurebench [books] [passes]
+
+using namespace ReadyTraderGo;
+using Levels = std::array<unsigned long, TOP_LEVEL_COUNT>;
+
+namespace {
+
+struct Book
+{
+    Levels mAskPrices;
+    Levels mAskVolumes;
+    Levels mBidPrices;
+    Levels mBidVolumes;
+};
+
+std::vector<Book> MakeBooks(std::size_t count)
+{
+    std::mt19937_64 rng(20210301);
+    std::uniform_int_distribution<unsigned long> mid(1000, 3000);
+    std::uniform_int_distribution<unsigned long> gap(1, 3);
+    std::uniform_int_distribution<unsigned long> volume(1, 500);
+    // Most updates show five levels a side; now and then a side is thin.
+    std::uniform_int_distribution<std::size_t> depth(0, 4 * TOP_LEVEL_COUNT);
+
+    std::vector<Book> books(count);
+    for (Book& book : books)
+    {
+        const unsigned long centre = mid(rng) * 100;
+        const std::size_t askLevels = std::min(depth(rng), TOP_LEVEL_COUNT);
+        const std::size_t bidLevels = std::min(depth(rng), TOP_LEVEL_COUNT);
+        unsigned long ask = centre + gap(rng) * 100;
+        unsigned long bid = centre - gap(rng) * 100;
+        for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+        {
+            book.mAskPrices[i] = (i < askLevels) ? ask : 0;
+            book.mAskVolumes[i] = (i < askLevels) ? volume(rng) : 0;
+            book.mBidPrices[i] = (i < bidLevels) ? bid : 0;
+            book.mBidVolumes[i] = (i < bidLevels) ? volume(rng) : 0;
+            ask += gap(rng) * 100;
+            bid -= gap(rng) * 100;
+        }
+    }
+    return books;
+}
+
+// The loop the autotrader ran before the feature kernel existed.
+double WeightedAverageSpread(const Book& book)
+{
+    double totalSpreadVolume = 0.0;
+    double weightedSpreadSum = 0.0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        if (book.mAskPrices[i] != 0 && book.mBidPrices[i] != 0)
+        {
+            double spread = (book.mAskPrices[i] - book.mBidPrices[i]) >> 1;
+            double spreadVolume = std::min(book.mAskVolumes[i], book.mBidVolumes[i]);
+            totalSpreadVolume += spreadVolume;
+            weightedSpreadSum += spread * spreadVolume;
+        }
+    }
+    return (totalSpreadVolume > 0.0) ? weightedSpreadSum / totalSpreadVolume : 0.0;
+}
+
+// The best of several runs, to keep noise from other processes out.
+template<typename F>
+double NanosecondsPerBook(const std::vector<Book>& books, std::size_t passes, F&& f)
+{
+    constexpr int RUNS = 7;
+    double best = 0.0;
+    for (int run = 0; run < RUNS; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t pass = 0; pass < passes; ++pass)
+        {
+            for (const Book& book : books)
+            {
+                f(book);
+            }
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        const double perBook = elapsed.count() / static_cast<double>(books.size() * passes);
+        best = (run == 0 || perBook < best) ? perBook : best;
+    }
+    return best;
+}
+
+bool Same(const BookFeatures& a, const BookFeatures& b)
+{
+    return a.mMicroNumerator == b.mMicroNumerator && a.mMicroVolume == b.mMicroVolume
+           && a.mSpreadNumerator == b.mSpreadNumerator && a.mSpreadVolume == b.mSpreadVolume
+           && a.mTouchSpread.Cents() == b.mTouchSpread.Cents() && a.mAskDepth == b.mAskDepth
+           && a.mBidDepth == b.mBidDepth;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t bookCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    const std::size_t passes = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 200;
+    const std::vector<Book> books = MakeBooks(bookCount);
+
+    std::size_t mismatches = 0;
+    for (const Book& book : books)
+    {
+        BookFeatures vector;
+        BookFeatures scalar;
+        ComputeBookFeatures(book.mAskPrices, book.mAskVolumes, book.mBidPrices, book.mBidVolumes, vector);
+        ComputeBookFeaturesScalar(book.mAskPrices, book.mAskVolumes, book.mBidPrices, book.mBidVolumes, scalar);
+        mismatches += Same(vector, scalar) ? 0 : 1;
+    }
+
+    // Accumulate into a volatile so the work cannot be optimised away.
+    volatile unsigned long sink = 0;
+    BookFeatures features;
+    const double spreadOnly = NanosecondsPerBook(books, passes, [&](const Book& book) {
+        sink = sink + static_cast<unsigned long>(WeightedAverageSpread(book));
+    });
+    // What the autotrader does per future book: gather the features and read
+    // the weighted half spread.
+    const double scalar = NanosecondsPerBook(books, passes, [&](const Book& book) {
+        ComputeBookFeaturesScalar(book.mAskPrices, book.mAskVolumes, book.mBidPrices, book.mBidVolumes, features);
+        sink = sink + static_cast<unsigned long>(features.WeightedHalfSpread().Cents());
+    });
+    const double kernel = NanosecondsPerBook(books, passes, [&](const Book& book) {
+        ComputeBookFeatures(book.mAskPrices, book.mAskVolumes, book.mBidPrices, book.mBidVolumes, features);
+        sink = sink + static_cast<unsigned long>(features.WeightedHalfSpread().Cents());
+    });
+    // The same plus every other ratio, for a strategy that uses them all.
+    const double everyRatio = NanosecondsPerBook(books, passes, [&](const Book& book) {
+        ComputeBookFeatures(book.mAskPrices, book.mAskVolumes, book.mBidPrices, book.mBidVolumes, features);
+        unsigned long total = features.Microprice().Cents() + features.SpreadTicks(100)
+                              + static_cast<unsigned long>(features.WeightedHalfSpread().Cents());
+        for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+        {
+            total += static_cast<unsigned long>(features.Imbalance(i));
+        }
+        sink = sink + total;
+    });
+
+    std::cout << "books: " << bookCount << ", passes: " << passes
+              << ", vectorised: " << (BookFeaturesVectorised() ? "yes" : "no") << '\n'
+              << "weighted average spread only: " << spreadOnly << " ns/book\n"
+              << "features + spread, scalar:    " << scalar << " ns/book\n"
+              << "features + spread, kernel:    " << kernel << " ns/book\n"
+              << "features + every ratio:       " << everyRatio << " ns/book\n"
+              << "mismatches: " << mismatches << std::endl;
+
+    return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/application.h>
+#include <ready_trader_go/autotraderapphandler.h>
+#include <ready_trader_go/error.h>
+
+#include "autotrader.h"
+
+// Runs several autotraders in one process. Each trader gets its own
+// Application (and therefore its own io_context and log file) and runs on
+// its own thread of a pool. The configuration file holds an array of
+// ordinary autotrader configurations, each of which may have a Strategy
+// section of its own (see AutoTraderParameters), as for backtest:
+//
+//     { "Traders": [ { "Execution": ..., "Information": ...,
+//                      "TeamName": "TraderOne", "Secret": "secret",
+//                      "Strategy": { "LotSize": 150 } }, ... ] }
+struct FleetMember
+{
+    explicit FleetMember(const AutoTraderParameters& parameters)
+        : trader(app.GetContext(), parameters), handler(app, trader) {}
+
+    ReadyTraderGo::Application app;
+    AutoTrader trader;
+    ReadyTraderGo::AutoTraderAppHandler handler;
+};
+
+int main(int argc, char* argv[])
+{
+    const std::string filename = (argc > 1) ? argv[1] : "fleet.json";
+
+    boost::property_tree::ptree tree;
+    try
+    {
+        boost::property_tree::read_json(filename, tree);
+    }
+    catch (const boost::property_tree::json_parser_error& e)
+    {
+        std::cerr << "failed while reading configuration file '" << filename << "': " << e.message() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<boost::property_tree::ptree> configs;
+    if (auto traders = tree.get_child_optional("Traders"))
+    {
+        for (auto& child : *traders)
+        {
+            configs.push_back(child.second);
+        }
+    }
+
+    if (configs.empty())
+    {
+        std::cerr << "no traders configured in '" << filename << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<FleetMember>> fleet;
+    for (std::size_t i = 0; i < configs.size(); ++i)
+    {
+        try
+        {
+            AutoTraderParameters parameters;
+            parameters.readFromPropertyTree(configs[i].get_child("Strategy", {}));
+            fleet.push_back(std::make_unique<FleetMember>(parameters));
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "bad strategy parameters for trader " << i << ": " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::atomic<int> status{EXIT_SUCCESS};
+    {
+        boost::asio::thread_pool pool{configs.size()};
+        for (std::size_t i = 0; i < configs.size(); ++i)
+        {
+            boost::asio::post(pool, [&, i] {
+                const std::string name = configs[i].get<std::string>("TeamName", "trader" + std::to_string(i));
+                try
+                {
+                    fleet[i]->app.Run(name, configs[i]);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << name << ": " << e.what() << std::endl;
+                    status = EXIT_FAILURE;
+                }
+            });
+        }
+        pool.join();
+    }
+
+    return status;
+}
@@ -0,0 +1,287 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifdef RTG_ALLOCATION_TRACKING
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <cxxabi.h>
+#include <execinfo.h>
+
+#include "allocation.h"
+#include "logging.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_ALLOC, "ALLOC")
+
+// glibc's own allocator entry points, which the replacements below hand on
+// to.
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* pointer);
+}
+
+namespace ReadyTraderGo {
+
+// Zero-initialised, so no constructor runs and no destructor is registered.
+static thread_local AllocationTracker tTracker;
+
+AllocationTracker& AllocationTracker::Local() noexcept
+{
+    return tTracker;
+}
+
+void AllocationTracker::RecordAllocation(std::size_t size) noexcept
+{
+    // backtrace() may allocate the first time it is called, and the logger
+    // certainly does, so nothing is recorded while already in here.
+    if (mArmed == 0 || mInHook)
+    {
+        return;
+    }
+    mInHook = true;
+
+    ++mAllocations;
+    mBytes += size;
+
+    // The first frame is this function; the allocator it was called from is
+    // kept, so that the report shows what kind of allocation it was.
+    std::array<void*, MAX_FRAMES + 1> frames;
+    const int depth = std::max(0, backtrace(frames.data(), static_cast<int>(frames.size())) - 1);
+
+    CallSite* site = nullptr;
+    for (std::size_t i = 0; i < mCallSiteCount; ++i)
+    {
+        CallSite& candidate = mCallSites[i];
+        if (candidate.mDepth == depth
+            && std::memcmp(candidate.mFrames.data(), frames.data() + 1, depth * sizeof(void*)) == 0)
+        {
+            site = &candidate;
+            break;
+        }
+    }
+    if (site == nullptr && mCallSiteCount < MAX_CALL_SITES)
+    {
+        site = &mCallSites[mCallSiteCount++];
+        std::memcpy(site->mFrames.data(), frames.data() + 1, depth * sizeof(void*));
+        site->mDepth = depth;
+    }
+
+    if (site != nullptr)
+    {
+        ++site->mCount;
+        site->mBytes += size;
+    }
+    else
+    {
+        ++mUnattributed;
+    }
+
+    mInHook = false;
+}
+
+// Turns one line of backtrace_symbols() output, "file(mangled+offset) [address]",
+// into "demangled+offset", falling back to the line as it is.
+static std::string Symbolise(const char* line)
+{
+    const char* open = std::strchr(line, '(');
+    const char* plus = open ? std::strchr(open, '+') : nullptr;
+    if (open == nullptr || plus == nullptr || plus == open + 1)
+    {
+        return line;
+    }
+
+    const std::string mangled(open + 1, plus);
+    const char* close = std::strchr(plus, ')');
+    const std::string offset = close ? std::string(plus, close) : std::string(plus);
+
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+    std::string result = (status == 0 && demangled != nullptr) ? std::string(demangled) + offset : mangled + offset;
+    std::free(demangled);
+    return result;
+}
+
+void AllocationTracker::Dump() const
+{
+    RLOG(LG_ALLOC, LogLevel::LL_INFO) << "hot path allocations: count=" << mAllocations << " bytes=" << mBytes
+                                      << " frees=" << mFrees << " call sites=" << mCallSiteCount
+                                      << " unattributed=" << mUnattributed;
+
+    std::vector<const CallSite*> sites;
+    for (std::size_t i = 0; i < mCallSiteCount; ++i)
+    {
+        sites.push_back(&mCallSites[i]);
+    }
+    std::sort(sites.begin(), sites.end(), [](const CallSite* a, const CallSite* b) { return a->mCount > b->mCount; });
+
+    for (const CallSite* site : sites)
+    {
+        RLOG(LG_ALLOC, LogLevel::LL_INFO) << "call site: count=" << site->mCount << " bytes=" << site->mBytes;
+        char** symbols = backtrace_symbols(const_cast<void* const*>(site->mFrames.data()), site->mDepth);
+        for (int i = 0; i < site->mDepth; ++i)
+        {
+            RLOG(LG_ALLOC, LogLevel::LL_INFO) << "    #" << i << ' '
+                                              << (symbols ? Symbolise(symbols[i]) : std::string("?"));
+        }
+        std::free(symbols);
+    }
+}
+
+}
+
+using ReadyTraderGo::AllocationTracker;
+
+// The C allocator. Everything else in the process, including libstdc++'s
+// own operator new where it is not replaced, comes through here.
+
+extern "C" void* malloc(std::size_t size)
+{
+    AllocationTracker::Local().RecordAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size)
+{
+    AllocationTracker::Local().RecordAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, std::size_t size)
+{
+    AllocationTracker::Local().RecordAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void* memalign(std::size_t alignment, std::size_t size)
+{
+    AllocationTracker::Local().RecordAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    AllocationTracker::Local().RecordAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** pointer, std::size_t alignment, std::size_t size)
+{
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    AllocationTracker::Local().RecordAllocation(size);
+    void* result = __libc_memalign(alignment, size);
+    if (result == nullptr)
+    {
+        return ENOMEM;
+    }
+    *pointer = result;
+    return 0;
+}
+
+extern "C" void free(void* pointer)
+{
+    if (pointer != nullptr)
+    {
+        AllocationTracker::Local().RecordFree();
+    }
+    __libc_free(pointer);
+}
+
+// operator new and delete, so that they are attributed to their caller
+// rather than to libstdc++.
+
+static void* NewImpl(std::size_t size, std::size_t alignment = 0)
+{
+    AllocationTracker::Local().RecordAllocation(size);
+    size = std::max<std::size_t>(size, 1);
+    for (;;)
+    {
+        void* result = (alignment != 0) ? __libc_memalign(alignment, size) : __libc_malloc(size);
+        if (result != nullptr)
+        {
+            return result;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void* NewNothrowImpl(std::size_t size, std::size_t alignment = 0) noexcept
+{
+    try
+    {
+        return NewImpl(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+static void DeleteImpl(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+    {
+        AllocationTracker::Local().RecordFree();
+    }
+    __libc_free(pointer);
+}
+
+void* operator new(std::size_t size) { return NewImpl(size); }
+void* operator new[](std::size_t size) { return NewImpl(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return NewImpl(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return NewImpl(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return NewNothrowImpl(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return NewNothrowImpl(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return NewNothrowImpl(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return NewNothrowImpl(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer) noexcept { DeleteImpl(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { DeleteImpl(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { DeleteImpl(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { DeleteImpl(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { DeleteImpl(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { DeleteImpl(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { DeleteImpl(pointer); }
+
+#endif
@@ -0,0 +1,120 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATION_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATION_H
+
+// Hot-path allocation tracking. Build with RTG_ALLOCATION_TRACKING (the
+// CMake option of the same name) to enable it; otherwise the
+// RTG_ALLOCATION_ macros expand to nothing and none of the code below is
+// compiled.
+//
+// When enabled, malloc, calloc, realloc, the aligned allocators, free and
+// every form of operator new and delete are replaced by versions that count
+// calls on the calling thread before handing them to glibc. Counting only
+// happens while the thread is inside an RTG_ALLOCATION_SCOPE, which the
+// library opens around everything done for an incoming frame or execution
+// message and for a timer wakeup, i.e. from frame arrival to order send.
+//
+// Each allocation made in scope is attributed to its call stack. The
+// distinct stacks, with their counts and sizes, are written to the log,
+// symbolised, when the application's run loop ends or on SIGUSR1. Anything
+// allocated only once is most likely warm-up; anything with a count that
+// grows with the number of messages is a regression. Link with -rdynamic
+// (the CMake option does) so that the stacks carry function names.
+
+#ifdef RTG_ALLOCATION_TRACKING
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ReadyTraderGo {
+
+class AllocationTracker
+{
+public:
+    static constexpr std::size_t MAX_FRAMES = 24;
+    static constexpr std::size_t MAX_CALL_SITES = 256;
+
+    // The tracker for the calling thread.
+    static AllocationTracker& Local() noexcept;
+
+    void Arm() noexcept { ++mArmed; }
+    void Disarm() noexcept { --mArmed; }
+
+    // Called by the replacement allocators.
+    void RecordAllocation(std::size_t size) noexcept;
+    void RecordFree() noexcept
+    {
+        if (mArmed != 0)
+        {
+            ++mFrees;
+        }
+    }
+
+    std::uint64_t Allocations() const noexcept { return mAllocations; }
+    std::uint64_t Frees() const noexcept { return mFrees; }
+
+    // Write the totals and every call site to the log.
+    void Dump() const;
+
+private:
+    struct CallSite
+    {
+        std::array<void*, MAX_FRAMES> mFrames;
+        int mDepth;
+        std::uint64_t mCount;
+        std::uint64_t mBytes;
+    };
+
+    // Everything is zero-initialised so that the per-thread instance needs
+    // no constructor or destructor, which could themselves allocate.
+    std::array<CallSite, MAX_CALL_SITES> mCallSites;
+    std::size_t mCallSiteCount;
+    std::uint64_t mAllocations;
+    std::uint64_t mBytes;
+    std::uint64_t mFrees;
+    std::uint64_t mUnattributed;                // Allocations made once the call site table was full.
+    int mArmed;
+    bool mInHook;
+};
+
+// Counts allocations on this thread for as long as it lives. Scopes nest.
+class AllocationScope
+{
+public:
+    AllocationScope() noexcept { AllocationTracker::Local().Arm(); }
+    ~AllocationScope() { AllocationTracker::Local().Disarm(); }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+}
+
+#define RTG_ALLOCATION_SCOPE() ::ReadyTraderGo::AllocationScope rtgAllocationScope
+#define RTG_ALLOCATION_DUMP() ::ReadyTraderGo::AllocationTracker::Local().Dump()
+
+#else
+
+#define RTG_ALLOCATION_SCOPE() do {} while (false)
+#define RTG_ALLOCATION_DUMP() do {} while (false)
+
+#endif
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATION_H
@@ -22,7 +22,10 @@
 #include <string>
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
-#include <boost/log/attributes/clock.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/log/attributes/constant.hpp>
+#include <boost/log/attributes/function.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
@@ -32,8 +35,11 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include "allocation.h"
 #include "application.h"
+#include "clock.h"
 #include "error.h"
+#include "latency.h"
 #include "logging.h"
 
 namespace logging = boost::log;
@@ -46,6 +52,7 @@ RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_APP, "APP")
 namespace ReadyTraderGo {
 
 BOOST_LOG_ATTRIBUTE_KEYWORD(rtg_severity, "Severity", LogLevel)
+BOOST_LOG_ATTRIBUTE_KEYWORD(rtg_application, "Application", std::string)
 
 // Return the stem of a given path, e.g. stem("/foo/bar.exe") returns "bar".
 static inline std::string stem(const std::string& path)
@@ -60,6 +67,22 @@ static inline std::string stem(const std::string& path)
     return filename;
 }
 
+// Log time stamps come from the calibrated clock rather than the system's
+// local time, which is far slower to read. The offset from UTC is looked up
+// once, so a daylight saving change during a run is not followed.
+static boost::posix_time::ptime LogTimeStamp()
+{
+    static const boost::posix_time::time_duration utcOffset = [] {
+        const boost::posix_time::ptime utc = boost::posix_time::second_clock::universal_time();
+        return boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utc) - utc;
+    }();
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    const auto sinceEpoch = Clock::ToWallTime(Clock::now()).time_since_epoch();
+    return epoch + utcOffset
+           + boost::posix_time::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count());
+}
+
 Application::~Application()
 {
     if (!mContext.stopped())
@@ -104,17 +127,54 @@ void Application::Run(int argc, char* argv[])
     RLOG(LG_APP, LogLevel::LL_INFO) << "application started";
 
     LoadConfig(mName + ".json");
+    RunContext();
+}
+
+void Application::Run(std::string name, const boost::property_tree::ptree& config)
+{
+    if (name.empty())
+    {
+        throw ReadyTraderGoError("application has no name");
+    }
+    mName = std::move(name);
+
+    SetUpLogging();
+    RLOG(LG_APP, LogLevel::LL_INFO) << "application started";
+
+    OnConfigLoaded(config);
+    RunContext();
+}
 
+void Application::RunContext()
+{
     // Add signal handling (to handle Ctrl-C, for example)
     mSignals.add(SIGINT);
     mSignals.add(SIGTERM);
 #ifdef SIGQUIT
     mSignals.add(SIGQUIT);
+#endif
+#if (defined(RTG_LATENCY_TRACING) || defined(RTG_ALLOCATION_TRACKING)) && defined(SIGUSR1)
+    mSignals.add(SIGUSR1);
 #endif
     mSignals.async_wait([this](const boost::system::error_code& ec, int s) { SignalHandler(ec, s); });
 
+    ScheduleClockCalibration();
     OnReadyToRun();
     mContext.run();
+    RTG_LATENCY_DUMP();
+    RTG_ALLOCATION_DUMP();
+}
+
+void Application::ScheduleClockCalibration()
+{
+    mCalibrationTimer.expires_after(Clock::CALIBRATION_INTERVAL);
+    mCalibrationTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            Clock::Calibrate();
+            ScheduleClockCalibration();
+        }
+    });
 }
 
 void Application::SetUpLogging()
@@ -128,7 +188,16 @@ void Application::SetUpLogging()
     }
 
     boost::shared_ptr<boost::log::core> core = logging::core::get();
-    core->add_global_attribute("TimeStamp", attrs::local_clock());
+    core->add_global_attribute("TimeStamp", attrs::make_function(&LogTimeStamp));
+
+    // Tag records from this thread so that, when several applications share
+    // the process, each sink only receives its own application's records.
+    auto attr = core->add_thread_attribute("Application", attrs::constant<std::string>(mName));
+    if (!attr.second)
+    {
+        core->remove_thread_attribute(attr.first);
+        core->add_thread_attribute("Application", attrs::constant<std::string>(mName));
+    }
 
     auto backend = boost::make_shared<sinks::text_ostream_backend>();
     backend->add_stream(boost::make_shared<std::ofstream>(std::move(logStream)));
@@ -143,12 +212,25 @@ void Application::SetUpLogging()
     );
 
 #ifdef NDEBUG
-    mSink->set_filter(rtg_severity > LogLevel::LL_DEBUG);
+    mSink->set_filter((!expr::has_attr(rtg_application) || rtg_application == mName)
+                      && rtg_severity > LogLevel::LL_DEBUG);
+#else
+    mSink->set_filter(!expr::has_attr(rtg_application) || rtg_application == mName);
 #endif
 }
 
 void Application::SignalHandler(const boost::system::error_code& error, int signal)
 {
+#if (defined(RTG_LATENCY_TRACING) || defined(RTG_ALLOCATION_TRACKING)) && defined(SIGUSR1)
+    if (!error && signal == SIGUSR1)
+    {
+        RTG_LATENCY_DUMP();
+        RTG_ALLOCATION_DUMP();
+        mSignals.async_wait([this](const boost::system::error_code& ec, int s) { SignalHandler(ec, s); });
+        return;
+    }
+#endif
+
     if (!error)
     {
         RLOG(LG_APP, LogLevel::LL_INFO) << "application received signal " << signal << ", shutting down";
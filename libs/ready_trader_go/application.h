@@ -25,6 +25,7 @@
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/log/sinks/async_frontend.hpp>
 #include <boost/log/sinks/bounded_fifo_queue.hpp>
 #include <boost/log/sinks/drop_on_overflow.hpp>
@@ -40,7 +41,7 @@ constexpr std::size_t LOG_QUEUE_SIZE = 1024;
 class Application
 {
 public:
-    Application() : mContext(), mName(), mSignals(mContext) {}
+    Application() : mContext(), mName(), mSignals(mContext), mCalibrationTimer(mContext) {}
     ~Application();
 
     // Application instances can't be copied or moved
@@ -53,6 +54,10 @@ public:
 
     void Run(int argc, char* argv[]);
 
+    // Run with an already-loaded configuration, e.g. when several
+    // applications share one process. The name is used for the log file.
+    void Run(std::string name, const boost::property_tree::ptree& config);
+
     std::function<void(const boost::property_tree::ptree&)> ConfigLoaded;
     std::function<void()> ReadyToRun;
 
@@ -61,6 +66,8 @@ private:
     void OnReadyToRun() const;
 
     void LoadConfig(const std::string& filename);
+    void RunContext();
+    void ScheduleClockCalibration();
     void SetUpLogging();
     void SignalHandler(const boost::system::error_code& error, int signal);
     void TearDownLogging();
@@ -68,6 +75,7 @@ private:
     boost::asio::io_context mContext;
     std::string mName;
     boost::asio::signal_set mSignals;
+    boost::asio::steady_timer mCalibrationTimer;
 
     using sink_t = boost::log::sinks::asynchronous_sink<
         boost::log::sinks::text_ostream_backend,
@@ -45,6 +45,13 @@ void AutoTraderAppHandler::ConfigLoadedHandler(const boost::property_tree::ptree
                                                                      config.mInfoName);
 
     mAutoTrader.SetLoginDetails(config.mTeamName, config.mSecret);
+    mAutoTrader.SetExchangeLimits(config.mLimits);
+
+    if (!config.mMetricsName.empty())
+    {
+        mMetricsPublisher = std::make_unique<MetricsPublisher>(config.mMetricsName);
+        mAutoTrader.SetMetrics(mMetricsPublisher->Segment());
+    }
 }
 
 void AutoTraderAppHandler::ReadyToRunHandler()
@@ -25,6 +25,7 @@
 #include "application.h"
 #include "baseautotrader.h"
 #include "connectivity.h"
+#include "metrics.h"
 
 namespace ReadyTraderGo {
 
@@ -48,6 +49,7 @@ private:
 
     std::unique_ptr<ConnectionFactory> mExecConnectionFactory;
     std::unique_ptr<SubscriptionFactory> mInfoSubscriptionFactory;
+    std::unique_ptr<MetricsPublisher> mMetricsPublisher;
 };
 
 }
@@ -0,0 +1,131 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include "barbuilder.h"
+
+namespace ReadyTraderGo {
+
+bool BarBuilder::Roll(Clock::time_point now)
+{
+    if (!mStarted)
+    {
+        mStarted = true;
+        mCurrent = Bar();
+        mCurrent.mStart = now;
+        return false;
+    }
+
+    const Clock::duration elapsed = now - mCurrent.mStart;
+    if (elapsed < mInterval)
+    {
+        return false;
+    }
+
+    // Bars stay on the grid set by the first one, whatever gaps there are.
+    const Clock::time_point start = mCurrent.mStart + (elapsed / mInterval) * mInterval;
+    const bool completed = mCurrent.mClose != 0;
+    if (completed)
+    {
+        mLast = mCurrent;
+        ++mBarCount;
+    }
+    mCurrent = Bar();
+    mCurrent.mStart = start;
+    return completed;
+}
+
+void BarBuilder::AddPrice(unsigned long low, unsigned long high, unsigned long close)
+{
+    if (mCurrent.mClose == 0)
+    {
+        mCurrent.mOpen = close;
+        mCurrent.mHigh = high;
+        mCurrent.mLow = low;
+    }
+    else
+    {
+        mCurrent.mHigh = std::max(mCurrent.mHigh, high);
+        mCurrent.mLow = std::min(mCurrent.mLow, low);
+    }
+    mCurrent.mClose = close;
+}
+
+bool BarBuilder::OnOrderBook(Clock::time_point now, unsigned long askPrice, unsigned long bidPrice)
+{
+    const bool completed = Roll(now);
+    if (!mCurrent.mTraded && askPrice != 0 && bidPrice != 0)
+    {
+        const unsigned long midpoint = (askPrice + bidPrice) / 2;
+        AddPrice(midpoint, midpoint, midpoint);
+    }
+    return completed;
+}
+
+bool BarBuilder::OnTradeTicks(Clock::time_point now,
+                              const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                              const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                              const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                              const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    const bool completed = Roll(now);
+
+    unsigned long low = MAXIMUM_ASK;
+    unsigned long high = 0;
+    unsigned long volume = 0;
+    unsigned long turnover = 0;
+    signed long flow = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        if (askPrices[i] != 0 && askVolumes[i] != 0)
+        {
+            low = std::min(low, askPrices[i]);
+            high = std::max(high, askPrices[i]);
+            volume += askVolumes[i];
+            turnover += askPrices[i] * askVolumes[i];
+            flow += static_cast<signed long>(askVolumes[i]);
+        }
+        if (bidPrices[i] != 0 && bidVolumes[i] != 0)
+        {
+            low = std::min(low, bidPrices[i]);
+            high = std::max(high, bidPrices[i]);
+            volume += bidVolumes[i];
+            turnover += bidPrices[i] * bidVolumes[i];
+            flow -= static_cast<signed long>(bidVolumes[i]);
+        }
+    }
+    if (volume == 0)
+    {
+        return completed;
+    }
+
+    if (!mCurrent.mTraded)
+    {
+        mCurrent.mClose = 0;
+        mCurrent.mTraded = true;
+    }
+    // The order of trades within one message is not known, so its average
+    // price stands in for the last trade.
+    AddPrice(low, high, turnover / volume);
+    mCurrent.mVolume += volume;
+    mCurrent.mTurnover += turnover;
+    mCurrent.mFlow += flow;
+    return completed;
+}
+
+}
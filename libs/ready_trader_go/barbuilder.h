@@ -0,0 +1,99 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BARBUILDER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BARBUILDER_H
+
+#include <array>
+#include <chrono>
+
+#include "clock.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// One time bucket of an instrument's market data. Prices are in cents and
+// volumes in lots.
+struct Bar
+{
+    Clock::time_point mStart;
+    unsigned long mOpen = 0;
+    unsigned long mHigh = 0;
+    unsigned long mLow = 0;
+    unsigned long mClose = 0;
+    unsigned long mVolume = 0;                  // Lots traded.
+    unsigned long mTurnover = 0;                // Sum of price * volume traded.
+    signed long mFlow = 0;                      // Lots bought at the ask less lots sold at the bid.
+    bool mTraded = false;                       // False if the prices are book midpoints.
+
+    // Volume-weighted average trade price, or the close if nothing traded.
+    unsigned long Vwap() const { return (mVolume != 0) ? mTurnover / mVolume : mClose; }
+};
+
+// Builds fixed-length bars from trade ticks and order book updates, keeping
+// only the bar in progress and the last one completed.
+//
+// The open, high, low and close come from trade prices. Until a bar sees a
+// trade they follow the order book midpoint instead, so that a quiet bucket
+// still has a price; the first trade then starts them afresh. In a trade
+// ticks message the ask prices are where buyers lifted offers and the bid
+// prices where sellers hit bids, which gives the signed flow.
+//
+// Every update first checks whether the bar in progress has run its time.
+// If so the bar is completed, and the update returns true with the bar in
+// LastBar(), so that indicators can be updated once per bar. Buckets with
+// no data at all are skipped rather than reported as empty bars.
+class BarBuilder
+{
+public:
+    using Clock = ReadyTraderGo::Clock;
+
+    explicit BarBuilder(Clock::duration interval = std::chrono::seconds(1)) : mInterval(interval) {}
+
+    void SetInterval(Clock::duration interval) { mInterval = interval; }
+    Clock::duration Interval() const { return mInterval; }
+
+    bool OnOrderBook(Clock::time_point now, unsigned long askPrice, unsigned long bidPrice);
+
+    bool OnTradeTicks(Clock::time_point now,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes);
+
+    // Complete the bar in progress if its time is up, without adding to it.
+    bool Roll(Clock::time_point now);
+
+    const Bar& CurrentBar() const { return mCurrent; }
+    const Bar& LastBar() const { return mLast; }
+
+    // Number of bars completed so far.
+    unsigned long BarCount() const { return mBarCount; }
+
+private:
+    void AddPrice(unsigned long low, unsigned long high, unsigned long close);
+
+    Clock::duration mInterval;
+    bool mStarted = false;
+    Bar mCurrent;
+    Bar mLast;
+    unsigned long mBarCount = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BARBUILDER_H
@@ -15,8 +15,12 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <boost/asio/post.hpp>
+
+#include "allocation.h"
 #include "baseautotrader.h"
 #include "error.h"
+#include "latency.h"
 #include "logging.h"
 #include "protocol.h"
 
@@ -24,6 +28,364 @@ RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_BAT, "BASE")
 
 namespace ReadyTraderGo {
 
+std::size_t BaseAutoTrader::MessageBudget(MessageLane lane)
+{
+    if (!mHeldUrgent.Empty() || (lane == MessageLane::NORMAL && !mHeldOrdered.Empty()))
+    {
+        return 0;
+    }
+    return mRateGovernor.Available(lane, MessageRateGovernor::Clock::now());
+}
+
+BaseAutoTrader::HeldMessage* BaseAutoTrader::FindHeld(unsigned long clientOrderId) noexcept
+{
+    const std::size_t insert = mHeldOrdered.Find([clientOrderId](const HeldMessage& m) {
+        return m.mType == MessageType::INSERT_ORDER && m.mClientOrderId == clientOrderId;
+    });
+    if (insert != mHeldOrdered.Size())
+    {
+        return &mHeldOrdered[insert];
+    }
+    const std::size_t urgent = mHeldUrgent.Find([clientOrderId](const HeldMessage& m) {
+        return m.mClientOrderId == clientOrderId;
+    });
+    return (urgent != mHeldUrgent.Size()) ? &mHeldUrgent[urgent] : nullptr;
+}
+
+void BaseAutoTrader::RejectLocally(unsigned long clientOrderId, RiskVerdict verdict, bool isInsert)
+{
+    RLOG(LG_BAT, LogLevel::LL_INFO) << "order " << clientOrderId << ": " << RiskVerdictMessage(verdict);
+    Increment(mMetrics->mLocalRejects);
+    boost::asio::post(mContext, [this, clientOrderId, verdict, isInsert] {
+        ErrorMessageHandler(clientOrderId, RiskVerdictMessage(verdict));
+        if (isInsert)
+        {
+            OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
+        }
+    });
+}
+
+void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, unsigned long volume)
+{
+    HeldMessage* held = FindHeld(clientOrderId);
+    RiskVerdict verdict = mRiskGate.CheckAmend(clientOrderId, volume);
+    if (verdict == RiskVerdict::ACCEPT && held == nullptr && mHeldUrgent.Full())
+    {
+        verdict = RiskVerdict::MESSAGE_BACKLOG;
+    }
+    if (verdict != RiskVerdict::ACCEPT)
+    {
+        RejectLocally(clientOrderId, verdict, false);
+        return;
+    }
+
+    mOrderManager.OnAmend(clientOrderId, volume);
+
+    if (held != nullptr)
+    {
+        // A held cancel already takes the order out of the market.
+        if (held->mType != MessageType::CANCEL_ORDER)
+        {
+            held->mVolume = volume;
+        }
+        return;
+    }
+
+    const HeldMessage message{MessageType::AMEND_ORDER, clientOrderId, Side::SELL, 0, volume, Lifespan::FILL_AND_KILL};
+    if (!mHeldUrgent.Empty() || !mRateGovernor.TryAcquire(MessageLane::URGENT, MessageRateGovernor::Clock::now()))
+    {
+        mHeldUrgent.Push(message);
+        ArmRateTimer();
+        return;
+    }
+    Send(message);
+}
+
+void BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId)
+{
+    const std::size_t insert = mHeldOrdered.Find([clientOrderId](const HeldMessage& m) {
+        return m.mType == MessageType::INSERT_ORDER && m.mClientOrderId == clientOrderId;
+    });
+    if (insert != mHeldOrdered.Size())
+    {
+        // The insert never reached the exchange, so finish the order here and
+        // report it the way the exchange would have.
+        mOrderManager.OnCancel(clientOrderId);
+        mHeldOrdered.Erase(insert);
+        mOrderManager.OnOrderStatus(clientOrderId, 0, 0, 0);
+        boost::asio::post(mContext, [this, clientOrderId] {
+            OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
+            mOrderManager.RetireIfDone(clientOrderId);
+        });
+        return;
+    }
+
+    HeldMessage* held = FindHeld(clientOrderId);
+    if (held == nullptr && mHeldUrgent.Full())
+    {
+        RejectLocally(clientOrderId, RiskVerdict::MESSAGE_BACKLOG, false);
+        return;
+    }
+
+    mOrderManager.OnCancel(clientOrderId);
+
+    if (held != nullptr)
+    {
+        held->mType = MessageType::CANCEL_ORDER;
+        held->mVolume = 0;
+        return;
+    }
+
+    const HeldMessage message{MessageType::CANCEL_ORDER, clientOrderId, Side::SELL, 0, 0, Lifespan::FILL_AND_KILL};
+    if (!mHeldUrgent.Empty() || !mRateGovernor.TryAcquire(MessageLane::URGENT, MessageRateGovernor::Clock::now()))
+    {
+        mHeldUrgent.Push(message);
+        ArmRateTimer();
+        return;
+    }
+    Send(message);
+}
+
+void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
+                                    Side side,
+                                    unsigned long price,
+                                    unsigned long volume)
+{
+    if (mHeldOrdered.Full())
+    {
+        RejectLocally(clientOrderId, RiskVerdict::MESSAGE_BACKLOG, false);
+        return;
+    }
+
+    const HeldMessage message{MessageType::HEDGE_ORDER, clientOrderId, side, price, volume, Lifespan::FILL_AND_KILL};
+    if (!mHeldUrgent.Empty() || !mHeldOrdered.Empty()
+        || !mRateGovernor.TryAcquire(MessageLane::URGENT, MessageRateGovernor::Clock::now()))
+    {
+        mHeldOrdered.Push(message);
+        ++mHeldHedgeCount;
+        ArmRateTimer();
+        return;
+    }
+    Send(message);
+}
+
+void BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId,
+                                     Side side,
+                                     unsigned long price,
+                                     unsigned long volume,
+                                     Lifespan lifespan)
+{
+    RiskVerdict verdict = mRiskGate.CheckInsert(side, price, volume);
+    if (verdict == RiskVerdict::ACCEPT && mHeldOrdered.Full())
+    {
+        verdict = RiskVerdict::MESSAGE_BACKLOG;
+    }
+    if (verdict != RiskVerdict::ACCEPT)
+    {
+        RejectLocally(clientOrderId, verdict, true);
+        return;
+    }
+
+    if (!mOrderManager.OnInsert(clientOrderId, side, price, volume))
+    {
+        RejectLocally(clientOrderId, RiskVerdict::ORDER_SLOT_IN_USE, true);
+        return;
+    }
+
+    const HeldMessage message{MessageType::INSERT_ORDER, clientOrderId, side, price, volume, lifespan};
+    if (!mHeldUrgent.Empty() || !mHeldOrdered.Empty()
+        || !mRateGovernor.TryAcquire(MessageLane::NORMAL, MessageRateGovernor::Clock::now()))
+    {
+        mHeldOrdered.Push(message);
+        ArmRateTimer();
+        return;
+    }
+    Send(message);
+}
+
+void BaseAutoTrader::Send(const HeldMessage& message)
+{
+    Increment(mMetrics->mMessagesOut[message.mType]);
+    switch (message.mType)
+    {
+    case MessageType::AMEND_ORDER:
+        mExecutionConnection->SendMessage(MessageType::AMEND_ORDER,
+                                          AmendMessage{message.mClientOrderId, message.mVolume});
+        break;
+    case MessageType::CANCEL_ORDER:
+        mExecutionConnection->SendMessage(MessageType::CANCEL_ORDER,
+                                          CancelMessage{message.mClientOrderId});
+        break;
+    case MessageType::HEDGE_ORDER:
+        mExecutionConnection->SendMessage(MessageType::HEDGE_ORDER,
+                                          HedgeMessage{message.mClientOrderId,
+                                                       message.mSide,
+                                                       message.mPrice,
+                                                       message.mVolume});
+        break;
+    case MessageType::INSERT_ORDER:
+        mExecutionConnection->SendMessage(MessageType::INSERT_ORDER,
+                                          InsertMessage{message.mClientOrderId,
+                                                        message.mSide,
+                                                        message.mPrice,
+                                                        message.mVolume,
+                                                        message.mLifespan});
+        break;
+    }
+}
+
+void BaseAutoTrader::ArmRateTimer()
+{
+    if (mRateTimerId != 0)
+    {
+        return;
+    }
+
+    // Scheduled on the wheel directly, as ScheduleTimer keeps the last slot
+    // for this.
+    mRateTimerId = mTimers.Schedule(mRateGovernor.NextRelease(), 0);
+    if (mRateGovernor.NextRelease() < mTimerWakeupAt)
+    {
+        ArmTimerWakeup();
+    }
+}
+
+TimerId BaseAutoTrader::ScheduleTimer(TimerWheel::Clock::time_point deadline, unsigned long token)
+{
+    if (mTimers.Active() + 1 >= mTimers.Capacity())
+    {
+        return 0;
+    }
+
+    const TimerId timerId = mTimers.Schedule(deadline, token);
+    if (deadline < mTimerWakeupAt)
+    {
+        ArmTimerWakeup();
+    }
+    return timerId;
+}
+
+TimerId BaseAutoTrader::ScheduleTimer(TimerWheel::Clock::duration delay, unsigned long token)
+{
+    return ScheduleTimer(TimerWheel::Clock::now() + delay, token);
+}
+
+// Make sure the wakeup timer goes off no later than the wheel next needs
+// advancing. Going off early is harmless, so it is only moved earlier.
+void BaseAutoTrader::ArmTimerWakeup()
+{
+    const TimerWheel::Clock::time_point wakeup = mTimers.NextWakeup();
+    if (wakeup >= mTimerWakeupAt)
+    {
+        return;
+    }
+
+    mTimerWakeupAt = wakeup;
+    mTimerWakeup.ExpiresAt(wakeup);
+}
+
+void BaseAutoTrader::TimerWakeupHandler()
+{
+    mTimerWakeupAt = TimerWheel::Clock::time_point::max();
+    PollTimers();
+}
+
+void BaseAutoTrader::PollTimers()
+{
+    mTimers.Advance(TimerWheel::Clock::now(), [this](TimerId timerId, unsigned long token) {
+        if (timerId == mRateTimerId)
+        {
+            mRateTimerId = 0;
+            FlushHeldMessages();
+        }
+        else
+        {
+            TimerHandler(timerId, token);
+        }
+    });
+    if (mTimers.Active() != 0)
+    {
+        ArmTimerWakeup();
+    }
+    PublishOrderMetrics();
+}
+
+void BaseAutoTrader::PublishOrderMetrics()
+{
+    Publish(mMetrics->mHeldMessages, static_cast<std::int64_t>(mHeldUrgent.Size() + mHeldOrdered.Size()));
+    Publish(mMetrics->mRateBudget, static_cast<std::int64_t>(MessageBudget()));
+    Publish(mMetrics->mActiveOrders, static_cast<std::int64_t>(mOrderManager.ActiveOrderCount()));
+    Publish(mMetrics->mEtfPosition, mOrderManager.Position());
+}
+
+bool BaseAutoTrader::AcceptSequence(Instrument instrument,
+                                    InformationStream stream,
+                                    unsigned long sequenceNumber,
+                                    Clock::time_point now)
+{
+    const char* streamName = (stream == InformationStream::ORDER_BOOK) ? "order book" : "trade ticks";
+
+    switch (mSequences.Check(instrument, stream, sequenceNumber, now))
+    {
+    case SequenceStatus::IN_SEQUENCE:
+        return true;
+    case SequenceStatus::GAP:
+        RLOG(LG_BAT, LogLevel::LL_WARNING) << "missed " << mSequences.Missed() << ' ' << instrument << ' '
+                                           << streamName << " messages before sequence number " << sequenceNumber;
+        Increment(mMetrics->mSequenceGaps, mSequences.Missed());
+        if (stream == InformationStream::TRADE_TICKS)
+        {
+            Increment(mMetrics->mRingOverruns, mSequences.Missed());
+        }
+        return true;
+    case SequenceStatus::DUPLICATE:
+    case SequenceStatus::OUT_OF_ORDER:
+        break;
+    }
+
+    RLOG(LG_BAT, LogLevel::LL_WARNING) << "dropped " << instrument << ' ' << streamName
+                                       << " message with sequence number " << sequenceNumber << " (latest is "
+                                       << mSequences.LastSequenceNumber(instrument, stream) << ')';
+    Increment(mMetrics->mSequenceDrops);
+    return false;
+}
+
+void BaseAutoTrader::FlushHeldMessages()
+{
+    const auto now = MessageRateGovernor::Clock::now();
+
+    while (!mHeldUrgent.Empty() && mRateGovernor.TryAcquire(MessageLane::URGENT, now))
+    {
+        Send(mHeldUrgent.Front());
+        mHeldUrgent.Pop();
+    }
+
+    // A held hedge lets the inserts ahead of it use the urgent lane, so the
+    // hedge is not stuck behind them.
+    while (mHeldUrgent.Empty() && !mHeldOrdered.Empty())
+    {
+        const HeldMessage& message = mHeldOrdered.Front();
+        const MessageLane lane = (mHeldHedgeCount != 0) ? MessageLane::URGENT : MessageLane::NORMAL;
+        if (!mRateGovernor.TryAcquire(lane, now))
+        {
+            break;
+        }
+        Send(message);
+        if (message.mType == MessageType::HEDGE_ORDER)
+        {
+            --mHeldHedgeCount;
+        }
+        mHeldOrdered.Pop();
+    }
+
+    if (!mHeldUrgent.Empty() || !mHeldOrdered.Empty())
+    {
+        RLOG(LG_BAT, LogLevel::LL_INFO) << "message frequency limit reached: holding "
+                                         << mHeldUrgent.Size() + mHeldOrdered.Size() << " messages";
+        ArmRateTimer();
+    }
+}
+
 void BaseAutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& connection)
 {
     mExecutionConnection = std::move(connection);
@@ -38,6 +400,7 @@ void BaseAutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& conne
                                     << "' and secret='" << mSecret << '\'';
     mExecutionConnection->SendMessage(MessageType::LOGIN,
                                       LoginMessage{mTeamName, mSecret});
+    Increment(mMetrics->mMessagesOut[MessageType::LOGIN]);
 
     mExecutionConnection->AsyncRead();
 }
@@ -47,12 +410,27 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
                                     unsigned char const* data,
                                     std::size_t size)
 {
+    if (mTimers.Active() != 0)
+    {
+        PollTimers();
+    }
+
+    Increment(mMetrics->mMessagesIn[messageType % METRICS_MESSAGE_TYPES]);
+    Publish(mMetrics->mHeartbeat, Clock::now().time_since_epoch().count());
+
     switch (messageType)
     {
     case MessageType::ERROR_MESSAGE:
     {
         auto err = makeMessage<ErrorMessage>(data, size);
+        Increment(mMetrics->mExchangeErrors);
+        const bool rejected = mOrderManager.OnError(err.mClientOrderId);
         ErrorMessageHandler(err.mClientOrderId, err.mMessage);
+        if (rejected)
+        {
+            OrderStatusMessageHandler(err.mClientOrderId, 0, 0, 0);
+            mOrderManager.RetireIfDone(err.mClientOrderId);
+        }
         break;
     }
     case MessageType::HEDGE_FILLED:
@@ -64,14 +442,18 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
     case MessageType::ORDER_FILLED:
     {
         auto filled = makeMessage<OrderFilledMessage>(data, size);
+        mOrderManager.OnOrderFilled(filled.mClientOrderId, filled.mPrice, filled.mVolume);
         OrderFilledMessageHandler(filled.mClientOrderId, filled.mPrice, filled.mVolume);
         break;
     }
     case MessageType::ORDER_STATUS:
     {
         auto status = makeMessage<OrderStatusMessage>(data, size);
+        mOrderManager.OnOrderStatus(status.mClientOrderId, status.mFillVolume,
+                                    status.mRemainingVolume, status.mFees);
         OrderStatusMessageHandler(status.mClientOrderId, status.mFillVolume,
                                   status.mRemainingVolume, status.mFees);
+        mOrderManager.RetireIfDone(status.mClientOrderId);
         break;
     }
     default:
@@ -81,6 +463,8 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
         throw ReadyTraderGoError("received execution message with unexpected type");
     }
     }
+
+    PublishOrderMetrics();
 }
 
 void BaseAutoTrader::MessageHandler(ISubscription* subscription,
@@ -88,18 +472,43 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
                                     unsigned char const* data,
                                     std::size_t size)
 {
+    if (mTimers.Active() != 0)
+    {
+        PollTimers();
+    }
+
+    const auto now = Clock::now();
+    Increment(mMetrics->mMessagesIn[messageType % METRICS_MESSAGE_TYPES]);
+    Publish(mMetrics->mHeartbeat, now.time_since_epoch().count());
+
     switch (messageType)
     {
     case MessageType::ORDER_BOOK_UPDATE:
     {
         auto book = makeMessage<OrderBookMessage>(data, size);
+        RTG_LATENCY_STAMP_DECODE(book.mSequenceNumber);
+        if (!AcceptSequence(book.mInstrument, InformationStream::ORDER_BOOK, book.mSequenceNumber, now))
+        {
+            break;
+        }
+        if (book.mInstrument == Instrument::FUTURE)
+        {
+            const bool twoSided = book.mAskPrices[0] != 0 && book.mBidPrices[0] != 0;
+            mRiskGate.SetReferencePrice(twoSided ? (book.mAskPrices[0] + book.mBidPrices[0]) / 2 : 0);
+        }
+        RTG_LATENCY_STAMP(STRATEGY_ENTRY);
         OrderBookMessageHandler(book.mInstrument, book.mSequenceNumber, book.mAskPrices,
                                 book.mAskVolumes, book.mBidPrices, book.mBidVolumes);
+        RTG_LATENCY_STAMP(STRATEGY_EXIT);
         break;
     }
     case MessageType::TRADE_TICKS:
     {
         auto ticks = makeMessage<TradeTicksMessage>(data, size);
+        if (!AcceptSequence(ticks.mInstrument, InformationStream::TRADE_TICKS, ticks.mSequenceNumber, now))
+        {
+            break;
+        }
         TradeTicksMessageHandler(ticks.mInstrument, ticks.mSequenceNumber, ticks.mAskPrices,
                                  ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes);
         break;
@@ -111,6 +520,8 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
         throw ReadyTraderGoError("received information message with unexpected type");
     }
     }
+
+    PublishOrderMetrics();
 }
 
 }
\ No newline at end of file
@@ -27,8 +27,17 @@
 
 #include <boost/asio/io_context.hpp>
 
+#include "boundedqueue.h"
 #include "connectivitytypes.h"
+#include "limits.h"
+#include "metrics.h"
+#include "ordermanager.h"
 #include "protocol.h"
+#include "rategovernor.h"
+#include "riskgate.h"
+#include "scheduler.h"
+#include "sequencetracker.h"
+#include "timerwheel.h"
 #include "types.h"
 
 namespace ReadyTraderGo {
@@ -36,7 +45,32 @@ namespace ReadyTraderGo {
 class BaseAutoTrader
 {
 public:
-    explicit BaseAutoTrader(boost::asio::io_context& context) : mContext(context) {};
+    explicit BaseAutoTrader(boost::asio::io_context& context)
+        : mContext(context), mRiskGate(mLimits, mOrderManager), mRateGovernor(mLimits),
+          mTimers(TIMER_CAPACITY), mTimerWakeup(context, [this] { TimerWakeupHandler(); }),
+          mHeldUrgent(mLimits.mMessageFrequencyLimit), mHeldOrdered(mLimits.mMessageFrequencyLimit) {};
+
+    // The most timers that may be scheduled at once.
+    static constexpr std::size_t TIMER_CAPACITY = 1024;
+
+    // Inserts and amends are checked by a RiskGate before they are sent, and
+    // an insert is refused if the order manager has no room to track it. One
+    // that fails is not sent; instead the strategy receives the error (and,
+    // for an insert, a zero order status) just as if the exchange had
+    // rejected it.
+    //
+    // Every order message goes through a client-side copy of the exchange's
+    // message frequency limiter. A message that would breach the limit is
+    // held back and sent as soon as the window allows:
+    //   * cancels and amends may jump ahead of held inserts and hedges;
+    //   * inserts and hedges are sent in order, since the exchange rejects
+    //     client order ids that go backwards;
+    //   * inserts leave part of the budget spare for the urgent lane;
+    //   * a cancel or amend of a held insert is folded into it, so neither
+    //     is sent if the insert was cancelled before it went out;
+    //   * likewise a cancel or amend of an order with a held amend replaces it.
+    // Each lane holds at most one interval's worth of messages; a message that
+    // would overflow it is rejected locally in the same way.
 
     virtual void SendAmendOrder(unsigned long clientOrderId, unsigned long volume);
     virtual void SendCancelOrder(unsigned long clientOrderId);
@@ -52,8 +86,46 @@ public:
 
     virtual void SetExecutionConnection(std::unique_ptr<IConnection>&& connection);
     virtual void SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription);
+    virtual void SetExchangeLimits(const ExchangeLimits& limits);
     virtual void SetLoginDetails(std::string teamName, std::string secret);
 
+    const ExchangeLimits& GetExchangeLimits() const { return mLimits; }
+
+    // The number of messages that could be sent on the given lane right now
+    // without any of them being held back.
+    std::size_t MessageBudget(MessageLane lane = MessageLane::NORMAL);
+
+    // Counters are published to the given segment, which must outlive the
+    // trader; until then they go to a private one.
+    void SetMetrics(MetricsSegment& metrics) { mMetrics = &metrics; }
+    MetricsSegment& GetMetrics() { return *mMetrics; }
+
+    const OrderManager& GetOrderManager() const { return mOrderManager; }
+    const RiskGate& GetRiskGate() const { return mRiskGate; }
+
+    // Order books and trade ticks are checked against a SequenceTracker
+    // before they are handled: duplicates and out-of-order messages are
+    // dropped and gaps are counted. BookAge is how long ago the latest order
+    // book for an instrument arrived, so that a strategy can hold off rather
+    // than quote from stale data; it is duration::max() before the first.
+    const SequenceTracker& GetSequenceTracker() const { return mSequences; }
+    Clock::duration BookAge(Instrument instrument) const
+    {
+        return mSequences.Age(instrument, InformationStream::ORDER_BOOK, Clock::now());
+    }
+
+    // Client order ids must increase with every insert or hedge, so all
+    // order ids should come from here.
+    unsigned long NextClientOrderId() { return mNextClientOrderId++; }
+
+    // Timers are kept in a TimerWheel, which is checked before each incoming
+    // message is handled and woken by a single DeadlineTimer when the wheel's
+    // next deadline comes first. TimerHandler is called with the token given
+    // here. Returns zero if TIMER_CAPACITY timers are already scheduled.
+    TimerId ScheduleTimer(TimerWheel::Clock::time_point deadline, unsigned long token);
+    TimerId ScheduleTimer(TimerWheel::Clock::duration delay, unsigned long token);
+    bool CancelTimer(TimerId timerId) { return mTimers.Cancel(timerId); }
+
 protected:
     boost::asio::io_context& mContext;
     std::unique_ptr<IConnection> mExecutionConnection = nullptr;
@@ -62,14 +134,58 @@ protected:
     std::string mTeamName;
     std::string mSecret;
 
+    ExchangeLimits mLimits;
+    OrderManager mOrderManager;
+    RiskGate mRiskGate;
+    unsigned long mNextClientOrderId = 1;
+
+    MessageRateGovernor mRateGovernor;
+    TimerId mRateTimerId = 0;
+
+    SequenceTracker mSequences;
+
+    MetricsSegment mLocalMetrics;
+    MetricsSegment* mMetrics = &mLocalMetrics;
+
+    TimerWheel mTimers;
+    DeadlineTimer mTimerWakeup;
+    TimerWheel::Clock::time_point mTimerWakeupAt = TimerWheel::Clock::time_point::max();
+
+    struct HeldMessage
+    {
+        unsigned char mType;
+        unsigned long mClientOrderId;
+        Side mSide;
+        unsigned long mPrice;
+        unsigned long mVolume;
+        Lifespan mLifespan;
+    };
+    BoundedQueue<HeldMessage> mHeldUrgent;      // Cancels and amends, at most one per order.
+    BoundedQueue<HeldMessage> mHeldOrdered;     // Inserts and hedges, in client order id order.
+    std::size_t mHeldHedgeCount = 0;
+
     virtual void DisconnectHandler();
+    void ArmRateTimer();
+    void ArmTimerWakeup();
+    void TimerWakeupHandler();
+    void PollTimers();
+    void PublishOrderMetrics();
+    bool AcceptSequence(Instrument instrument, InformationStream stream, unsigned long sequenceNumber,
+                        Clock::time_point now);
+    void FlushHeldMessages();
+    HeldMessage* FindHeld(unsigned long clientOrderId) noexcept;
+    void RejectLocally(unsigned long clientOrderId, RiskVerdict verdict, bool isInsert);
+    void Send(const HeldMessage& message);
     virtual void MessageHandler(IConnection*, unsigned char, unsigned char const*, std::size_t);
     virtual void MessageHandler(ISubscription* subscription,
                                 unsigned char messageType,
                                 unsigned char const* data,
                                 std::size_t size);
 
-    // Message callbacks
+    // Message callbacks. Order-related messages are applied to the order
+    // manager before the callback is invoked. When an error message rejects
+    // an order insert, OrderStatusMessageHandler is also called with zero
+    // remaining volume so strategies see every order finish the same way.
     virtual void ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string& errorMessage) {};
     virtual void HedgeFilledMessageHandler(unsigned long clientOrderId,
@@ -94,6 +210,7 @@ protected:
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) {};
+    virtual void TimerHandler(TimerId timerId, unsigned long token) {};
 };
 
 inline void BaseAutoTrader::DisconnectHandler()
@@ -112,42 +229,12 @@ inline void BaseAutoTrader::SetInformationSubscription(std::shared_ptr<ISubscrip
     mInformationSubscription->AsyncReceive();
 }
 
-inline void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, unsigned long volume)
-{
-    mExecutionConnection->SendMessage(MessageType::AMEND_ORDER,
-                                      AmendMessage{clientOrderId, volume});
-}
-
-inline void BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId)
-{
-    mExecutionConnection->SendMessage(MessageType::CANCEL_ORDER,
-                                      CancelMessage{clientOrderId});
-}
-
-inline void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
-                                           Side side,
-                                           unsigned long price,
-                                           unsigned long volume)
-{
-    mExecutionConnection->SendMessage(MessageType::HEDGE_ORDER,
-                                      HedgeMessage{clientOrderId,
-                                                   side,
-                                                   price,
-                                                   volume});
-}
-
-inline void BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId,
-                                            Side side,
-                                            unsigned long price,
-                                            unsigned long volume,
-                                            Lifespan lifespan)
+inline void BaseAutoTrader::SetExchangeLimits(const ExchangeLimits& limits)
 {
-    mExecutionConnection->SendMessage(MessageType::INSERT_ORDER,
-                                      InsertMessage{clientOrderId,
-                                                    side,
-                                                    price,
-                                                    volume,
-                                                    lifespan});
+    mLimits = limits;
+    mRateGovernor.SetLimits(limits);
+    mHeldUrgent.SetCapacity(limits.mMessageFrequencyLimit);
+    mHeldOrdered.SetCapacity(limits.mMessageFrequencyLimit);
 }
 
 inline void BaseAutoTrader::SetLoginDetails(std::string teamName, std::string secret)
@@ -0,0 +1,172 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define RTG_HAVE_AVX2_KERNEL 1
+#endif
+
+#include "bookfeatures.h"
+
+namespace ReadyTraderGo {
+
+namespace {
+
+inline void AddLevel(BookFeatures& sums,
+                     unsigned long askPrice,
+                     unsigned long askVolume,
+                     unsigned long bidPrice,
+                     unsigned long bidVolume) noexcept
+{
+    if (askPrice != 0 && bidPrice != 0 && askPrice > bidPrice)
+    {
+        const unsigned long minVolume = std::min(askVolume, bidVolume);
+        sums.mMicroNumerator += bidPrice * askVolume + askPrice * bidVolume;
+        sums.mMicroVolume += askVolume + bidVolume;
+        sums.mSpreadNumerator += ((askPrice - bidPrice) >> 1) * minVolume;
+        sums.mSpreadVolume += minVolume;
+    }
+}
+
+// Work shared by both versions: the touch spread and the depth prefix sums,
+// a handful of adds. The divides are left to the accessors.
+inline void Finish(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                   const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                   const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                   const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                   BookFeatures& features) noexcept
+{
+    const bool twoSided = askPrices[0] != 0 && bidPrices[0] != 0 && askPrices[0] > bidPrices[0];
+    features.mTouchSpread = PriceDelta(twoSided ? static_cast<signed long>(askPrices[0] - bidPrices[0]) : 0);
+
+    // Volumes fit in 32 bits, so these plain adds cannot overflow.
+    unsigned long askDepth = 0;
+    unsigned long bidDepth = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        askDepth += askVolumes[i];
+        bidDepth += bidVolumes[i];
+        features.mAskDepth[i] = Volume(askDepth);
+        features.mBidDepth[i] = Volume(bidDepth);
+    }
+}
+
+#ifdef RTG_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+void WeightedSumsAvx2(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                      BookFeatures& sums) noexcept
+{
+    static_assert(TOP_LEVEL_COUNT >= 4, "the vector kernel handles the first four levels at once");
+
+    // Levels 0-3, one per 64-bit lane.
+    const __m256i ap = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(askPrices.data()));
+    const __m256i av = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(askVolumes.data()));
+    const __m256i bp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bidPrices.data()));
+    const __m256i bv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bidVolumes.data()));
+
+    // A level counts if both prices are present and it is not crossed. The
+    // signed compare is safe because prices are below 2^63.
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i missing = _mm256_or_si256(_mm256_cmpeq_epi64(ap, zero), _mm256_cmpeq_epi64(bp, zero));
+    const __m256i valid = _mm256_andnot_si256(missing, _mm256_cmpgt_epi64(ap, bp));
+
+    const __m256i microNumerator = _mm256_and_si256(valid, _mm256_add_epi64(_mm256_mul_epu32(bp, av),
+                                                                            _mm256_mul_epu32(ap, bv)));
+    const __m256i microVolume = _mm256_and_si256(valid, _mm256_add_epi64(av, bv));
+
+    const __m256i minVolume = _mm256_blendv_epi8(av, bv, _mm256_cmpgt_epi64(av, bv));
+    const __m256i halfSpread = _mm256_srli_epi64(_mm256_sub_epi64(ap, bp), 1);
+    const __m256i spreadNumerator = _mm256_and_si256(valid, _mm256_mul_epu32(halfSpread, minVolume));
+    const __m256i spreadVolume = _mm256_and_si256(valid, minVolume);
+
+    // Transpose so that one add of the four rows sums every lane.
+    const __m256i lo0 = _mm256_unpacklo_epi64(microNumerator, microVolume);
+    const __m256i hi0 = _mm256_unpackhi_epi64(microNumerator, microVolume);
+    const __m256i lo1 = _mm256_unpacklo_epi64(spreadNumerator, spreadVolume);
+    const __m256i hi1 = _mm256_unpackhi_epi64(spreadNumerator, spreadVolume);
+    const __m256i pairs0 = _mm256_add_epi64(lo0, hi0);
+    const __m256i pairs1 = _mm256_add_epi64(lo1, hi1);
+    const __m256i totals = _mm256_add_epi64(_mm256_permute2x128_si256(pairs0, pairs1, 0x20),
+                                            _mm256_permute2x128_si256(pairs0, pairs1, 0x31));
+
+    alignas(32) std::array<unsigned long, 4> lanes;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), totals);
+    sums.mMicroNumerator = lanes[0];
+    sums.mMicroVolume = lanes[1];
+    sums.mSpreadNumerator = lanes[2];
+    sums.mSpreadVolume = lanes[3];
+
+    for (std::size_t i = 4; i < TOP_LEVEL_COUNT; ++i)
+    {
+        AddLevel(sums, askPrices[i], askVolumes[i], bidPrices[i], bidVolumes[i]);
+    }
+}
+
+const bool sHaveAvx2 = __builtin_cpu_supports("avx2");
+#endif
+
+}
+
+bool BookFeaturesVectorised() noexcept
+{
+#ifdef RTG_HAVE_AVX2_KERNEL
+    return sHaveAvx2;
+#else
+    return false;
+#endif
+}
+
+void ComputeBookFeaturesScalar(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                               BookFeatures& features) noexcept
+{
+    features.mMicroNumerator = 0;
+    features.mMicroVolume = 0;
+    features.mSpreadNumerator = 0;
+    features.mSpreadVolume = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        AddLevel(features, askPrices[i], askVolumes[i], bidPrices[i], bidVolumes[i]);
+    }
+    Finish(askPrices, askVolumes, bidPrices, bidVolumes, features);
+}
+
+void ComputeBookFeatures(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                         BookFeatures& features) noexcept
+{
+#ifdef RTG_HAVE_AVX2_KERNEL
+    if (sHaveAvx2)
+    {
+        WeightedSumsAvx2(askPrices, askVolumes, bidPrices, bidVolumes, features);
+        Finish(askPrices, askVolumes, bidPrices, bidVolumes, features);
+        return;
+    }
+#endif
+    ComputeBookFeaturesScalar(askPrices, askVolumes, bidPrices, bidVolumes, features);
+}
+
+}
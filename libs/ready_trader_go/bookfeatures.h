@@ -0,0 +1,103 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "price.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// Imbalances are fixed-point fractions of this.
+constexpr signed long IMBALANCE_SCALE = 10000;
+
+// Features of one order book update. Levels where either side is missing,
+// or where the book is crossed, are left out of the microprice and the
+// weighted half spread.
+//
+// Each ratio is kept as its numerator and denominator and only divided when
+// asked for, so a strategy pays for the divides it uses and no others. The
+// divides truncate, as with the Price and Volume types; a ratio with no
+// volume behind it is zero.
+struct BookFeatures
+{
+    // sum(bidPrice * askVolume + askPrice * bidVolume) / sum(askVolume + bidVolume)
+    unsigned long mMicroNumerator = 0;
+    unsigned long mMicroVolume = 0;
+    // sum(halfSpread * min(askVolume, bidVolume)) / sum(min(askVolume, bidVolume))
+    unsigned long mSpreadNumerator = 0;
+    unsigned long mSpreadVolume = 0;
+    // The spread at the touch, or zero if either side is missing.
+    PriceDelta mTouchSpread;
+    // Volume on each side down to and including each level.
+    std::array<Volume, TOP_LEVEL_COUNT> mAskDepth = {};
+    std::array<Volume, TOP_LEVEL_COUNT> mBidDepth = {};
+
+    Price Microprice() const noexcept
+    {
+        return Price(mMicroNumerator / std::max(mMicroVolume, 1UL));
+    }
+
+    PriceDelta WeightedHalfSpread() const noexcept
+    {
+        return PriceDelta(static_cast<signed long>(mSpreadNumerator / std::max(mSpreadVolume, 1UL)));
+    }
+
+    unsigned long SpreadTicks(unsigned long tickSize) const noexcept
+    {
+        return static_cast<unsigned long>(mTouchSpread.Cents()) / tickSize;
+    }
+
+    // (bidDepth - askDepth) / (bidDepth + askDepth) down to the given level,
+    // scaled by IMBALANCE_SCALE: positive when there is more to buy than to
+    // sell.
+    signed long Imbalance(std::size_t level) const noexcept
+    {
+        const signed long ask = static_cast<signed long>(mAskDepth[level].Lots());
+        const signed long bid = static_cast<signed long>(mBidDepth[level].Lots());
+        return (bid - ask) * IMBALANCE_SCALE / std::max(ask + bid, 1L);
+    }
+};
+
+// Gather every feature in one pass over the four arrays of an order book
+// message. The weighted sums use 32x32->64 bit multiplies, so prices and
+// volumes must fit in 32 bits (as they always do on the wire). Uses AVX2
+// for the sums when the CPU has it.
+void ComputeBookFeatures(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                         BookFeatures& features) noexcept;
+
+// Plain C++ version of the above, which the vector version must match.
+void ComputeBookFeaturesScalar(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                               const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes,
+                               BookFeatures& features) noexcept;
+
+// True if ComputeBookFeatures uses the vector version on this CPU.
+bool BookFeaturesVectorised() noexcept;
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
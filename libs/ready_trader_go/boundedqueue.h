@@ -0,0 +1,118 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOUNDEDQUEUE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOUNDEDQUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ReadyTraderGo {
+
+// A first-in first-out queue held in a ring buffer of fixed capacity. The
+// storage is allocated by SetCapacity, so pushing and popping never allocate;
+// Push fails instead when the queue is full.
+template<typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue() = default;
+    explicit BoundedQueue(std::size_t capacity) { SetCapacity(capacity); }
+
+    // Change the capacity, keeping the queued items. The capacity never drops
+    // below the number of items already queued.
+    void SetCapacity(std::size_t capacity)
+    {
+        if (capacity < mCount)
+        {
+            capacity = mCount;
+        }
+        std::vector<T> items(capacity);
+        for (std::size_t i = 0; i != mCount; ++i)
+        {
+            items[i] = (*this)[i];
+        }
+        mItems.swap(items);
+        mHead = 0;
+    }
+
+    std::size_t Capacity() const noexcept { return mItems.size(); }
+    std::size_t Size() const noexcept { return mCount; }
+    bool Empty() const noexcept { return mCount == 0; }
+    bool Full() const noexcept { return mCount == mItems.size(); }
+
+    // The item at the given position, counting from the front of the queue.
+    T& operator[](std::size_t i) noexcept { return mItems[Slot(i)]; }
+    const T& operator[](std::size_t i) const noexcept { return mItems[Slot(i)]; }
+
+    T& Front() noexcept { return mItems[mHead]; }
+
+    bool Push(const T& item) noexcept
+    {
+        if (Full())
+        {
+            return false;
+        }
+        mItems[Slot(mCount)] = item;
+        ++mCount;
+        return true;
+    }
+
+    void Pop() noexcept
+    {
+        mHead = Slot(1);
+        --mCount;
+    }
+
+    // Remove the item at the given position, keeping the rest in order.
+    void Erase(std::size_t i) noexcept
+    {
+        for (; i + 1 < mCount; ++i)
+        {
+            (*this)[i] = (*this)[i + 1];
+        }
+        --mCount;
+    }
+
+    // The position of the first item satisfying the predicate, or Size() if
+    // there is none.
+    template<typename Predicate>
+    std::size_t Find(Predicate predicate) const
+    {
+        std::size_t i = 0;
+        while (i != mCount && !predicate((*this)[i]))
+        {
+            ++i;
+        }
+        return i;
+    }
+
+private:
+    std::size_t Slot(std::size_t i) const noexcept
+    {
+        const std::size_t slot = mHead + i;
+        return (slot >= mItems.size()) ? slot - mItems.size() : slot;
+    }
+
+    std::vector<T> mItems;
+    std::size_t mHead = 0;
+    std::size_t mCount = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOUNDEDQUEUE_H
@@ -0,0 +1,173 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+namespace {
+
+// How long the first calibration watches the counter for.
+constexpr std::int64_t INITIAL_CALIBRATION_NANOSECONDS = 2000000;
+
+// Recalibration slews the rate by at most this fraction.
+constexpr std::int64_t MAXIMUM_SLEW_DIVISOR = 10000;
+
+struct Sample
+{
+    std::uint64_t mCycles;
+    std::int64_t mMonotonicRaw;
+    std::int64_t mRealtime;
+};
+
+// Both are constant-initialised, so they are ready however early the clock
+// is first used.
+std::mutex sCalibrationMutex;
+Sample sFirstSample = {};
+
+bool HaveInvariantCounter() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+    {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+std::int64_t RealtimeNanoseconds() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Read the counter either side of the two clocks, a few times over, and keep
+// the tightest pair so that the readings are as close together as possible.
+Sample TakeSample(bool usesCounter) noexcept
+{
+    Sample best = {};
+    std::uint64_t bestSpread = UINT64_MAX;
+    for (int i = 0; i < 5; ++i)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        const std::uint64_t before = usesCounter ? __rdtsc() : 0;
+        const std::int64_t monotonicRaw = MonotonicRawNanoseconds();
+        const std::int64_t realtime = RealtimeNanoseconds();
+        const std::uint64_t after = usesCounter ? __rdtsc() : 0;
+#else
+        const std::uint64_t before = 0;
+        const std::int64_t monotonicRaw = MonotonicRawNanoseconds();
+        const std::int64_t realtime = RealtimeNanoseconds();
+        const std::uint64_t after = 0;
+#endif
+        if (after - before < bestSpread)
+        {
+            bestSpread = after - before;
+            best = {before + (after - before) / 2, monotonicRaw, realtime};
+        }
+    }
+    if (!usesCounter)
+    {
+        best.mCycles = static_cast<std::uint64_t>(best.mMonotonicRaw);
+    }
+    return best;
+}
+
+std::uint64_t Multiplier(std::int64_t nanoseconds, std::uint64_t cycles, unsigned shift) noexcept
+{
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(nanoseconds) << shift) / cycles);
+}
+
+}
+
+Clock::Calibration::Calibration() noexcept : mUsesCounter(HaveInvariantCounter())
+{
+    // The counter can't be read through Clock here, as the clock's state is
+    // still being constructed.
+    sFirstSample = TakeSample(mUsesCounter);
+    if (!mUsesCounter)
+    {
+        mMultiplier = std::uint64_t(1) << MULTIPLIER_SHIFT;
+        mWallOffset = sFirstSample.mRealtime - sFirstSample.mMonotonicRaw;
+        return;
+    }
+
+    Sample second;
+    do
+    {
+        second = TakeSample(true);
+    }
+    while (second.mMonotonicRaw - sFirstSample.mMonotonicRaw < INITIAL_CALIBRATION_NANOSECONDS);
+
+    mMultiplier = Multiplier(second.mMonotonicRaw - sFirstSample.mMonotonicRaw,
+                             second.mCycles - sFirstSample.mCycles, MULTIPLIER_SHIFT);
+    mAnchorCycles = second.mCycles;
+    mAnchorNanoseconds = second.mMonotonicRaw;
+    mWallOffset = second.mRealtime - second.mMonotonicRaw;
+}
+
+void Clock::Calibrate() noexcept
+{
+    Calibration& state = State();
+    std::lock_guard<std::mutex> lock(sCalibrationMutex);
+
+    const Sample sample = TakeSample(state.mUsesCounter);
+    const std::int64_t now = CyclesToNanoseconds(sample.mCycles);
+    std::uint64_t multiplier = state.mMultiplier.load(std::memory_order_relaxed);
+    if (state.mUsesCounter && sample.mCycles > sFirstSample.mCycles)
+    {
+        multiplier = Multiplier(sample.mMonotonicRaw - sFirstSample.mMonotonicRaw,
+                                sample.mCycles - sFirstSample.mCycles, MULTIPLIER_SHIFT);
+
+        // Aim to be back in step with CLOCK_MONOTONIC_RAW by the next
+        // calibration, without changing the rate by much.
+        const std::int64_t ahead = now - sample.mMonotonicRaw;
+        const std::int64_t interval = std::chrono::nanoseconds(CALIBRATION_INTERVAL).count();
+        const auto limit = static_cast<std::int64_t>(multiplier / MAXIMUM_SLEW_DIVISOR);
+        const auto slew = static_cast<std::int64_t>(static_cast<__int128>(multiplier) * ahead / interval);
+        multiplier -= std::clamp(slew, -limit, limit);
+    }
+
+    const std::uint32_t sequence = state.mSequence.load(std::memory_order_relaxed);
+    state.mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    state.mAnchorCycles.store(sample.mCycles, std::memory_order_relaxed);
+    state.mAnchorNanoseconds.store(now, std::memory_order_relaxed);
+    state.mMultiplier.store(multiplier, std::memory_order_relaxed);
+    state.mWallOffset.store(sample.mRealtime - now, std::memory_order_relaxed);
+    state.mSequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool Clock::UsesTimestampCounter() noexcept
+{
+    return State().mUsesCounter;
+}
+
+}
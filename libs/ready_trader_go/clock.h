@@ -0,0 +1,176 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ReadyTraderGo {
+
+// A monotonic nanosecond clock read from the time stamp counter, which costs
+// a few nanoseconds rather than the tens that std::chrono or Boost.Log's
+// clocks do.
+//
+// The counter is calibrated against CLOCK_MONOTONIC_RAW when the clock is
+// first used, and again by each call to Calibrate (Application does this
+// every CALIBRATION_INTERVAL). Each calibration measures the counter's rate
+// over everything since the first, and is anchored where the previous one
+// had got to so that time never steps backwards; any difference from
+// CLOCK_MONOTONIC_RAW is slewed out over the following interval. Wall time is
+// anchored to CLOCK_REALTIME at each calibration.
+//
+// Without an invariant counter (or off x86) the clock reads
+// CLOCK_MONOTONIC_RAW directly and "cycles" are nanoseconds.
+//
+// A replay can run the clock on simulated time instead: while a thread has
+// a simulated time set (an EventScheduler sets one), now() on that thread
+// returns it and ToWallTime takes it to be time since the Unix epoch, so
+// that log time stamps come out the same on every run. Cycles always reads
+// the counter, so latency stamps still measure the real cost of handling
+// each message.
+//
+// Meets the standard's Clock requirements, hence the lower-case names.
+class Clock
+{
+public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<Clock, duration>;
+    static constexpr bool is_steady = true;
+
+    static constexpr std::chrono::seconds CALIBRATION_INTERVAL{1};
+
+    static time_point now() noexcept
+    {
+        if (sSimulatedTime != nullptr)
+        {
+            return *sSimulatedTime;
+        }
+        return time_point(duration(CyclesToNanoseconds(Cycles())));
+    }
+
+    // Make now() on this thread return whatever the given time point holds,
+    // or read the counter again if it is null. The caller advances the time
+    // and keeps it alive for as long as it is set.
+    static void SetSimulatedTime(const time_point* time) noexcept { sSimulatedTime = time; }
+
+    // The raw counter, for stamping where only differences are wanted.
+    static std::uint64_t Cycles() noexcept;
+
+    // A reading of Cycles as nanoseconds on this clock.
+    static rep CyclesToNanoseconds(std::uint64_t cycles) noexcept;
+
+    // The length of an interval measured in cycles.
+    static rep CycleIntervalToNanoseconds(std::uint64_t cycles) noexcept;
+
+    static std::chrono::system_clock::time_point ToWallTime(time_point time) noexcept;
+
+    static void Calibrate() noexcept;
+    static bool UsesTimestampCounter() noexcept;
+
+private:
+    // Written under a sequence lock so that readers never wait: the sequence
+    // is odd while an update is in progress.
+    struct Calibration
+    {
+        Calibration() noexcept;
+
+        std::atomic<std::uint32_t> mSequence{0};
+        std::atomic<std::uint64_t> mAnchorCycles{0};
+        std::atomic<std::int64_t> mAnchorNanoseconds{0};
+        std::atomic<std::uint64_t> mMultiplier{0};      // Nanoseconds per cycle, times 2^MULTIPLIER_SHIFT.
+        std::atomic<std::int64_t> mWallOffset{0};       // CLOCK_REALTIME less this clock.
+        bool mUsesCounter = false;
+    };
+
+    static constexpr unsigned MULTIPLIER_SHIFT = 32;
+
+    static inline thread_local const time_point* sSimulatedTime = nullptr;
+
+    static Calibration& State() noexcept
+    {
+        static Calibration state;
+        return state;
+    }
+
+    static std::int64_t Scale(std::int64_t cycles, std::uint64_t multiplier) noexcept
+    {
+        return static_cast<std::int64_t>((static_cast<__int128>(cycles) * multiplier) >> MULTIPLIER_SHIFT);
+    }
+};
+
+inline std::int64_t MonotonicRawNanoseconds() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+inline std::uint64_t Clock::Cycles() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (State().mUsesCounter)
+    {
+        return __rdtsc();
+    }
+#endif
+    return static_cast<std::uint64_t>(MonotonicRawNanoseconds());
+}
+
+inline Clock::rep Clock::CyclesToNanoseconds(std::uint64_t cycles) noexcept
+{
+    const Calibration& state = State();
+    std::uint32_t sequence;
+    std::int64_t nanoseconds;
+    do
+    {
+        sequence = state.mSequence.load(std::memory_order_acquire);
+        const std::uint64_t anchor = state.mAnchorCycles.load(std::memory_order_relaxed);
+        nanoseconds = state.mAnchorNanoseconds.load(std::memory_order_relaxed)
+                      + Scale(static_cast<std::int64_t>(cycles - anchor), state.mMultiplier.load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((sequence & 1) != 0 || sequence != state.mSequence.load(std::memory_order_relaxed));
+    return nanoseconds;
+}
+
+inline Clock::rep Clock::CycleIntervalToNanoseconds(std::uint64_t cycles) noexcept
+{
+    return Scale(static_cast<std::int64_t>(cycles), State().mMultiplier.load(std::memory_order_relaxed));
+}
+
+inline std::chrono::system_clock::time_point Clock::ToWallTime(time_point time) noexcept
+{
+    const std::int64_t offset = (sSimulatedTime != nullptr) ? 0 : State().mWallOffset.load(std::memory_order_relaxed);
+    const std::int64_t wall = time.time_since_epoch().count() + offset;
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(wall)));
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
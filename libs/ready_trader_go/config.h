@@ -22,6 +22,9 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include "limits.h"
+#include "metrics.h"
+
 namespace ReadyTraderGo {
 
 struct Config
@@ -36,6 +39,11 @@ struct Config
 
         mTeamName = tree.get<std::string>("TeamName");
         mSecret = tree.get<std::string>("Secret");
+
+        mLimits.readFromPropertyTree(tree);
+
+        // An empty name turns the metrics segment off.
+        mMetricsName = tree.get<std::string>("Metrics", MetricsSegmentName(mTeamName));
     }
 
     std::string mExecHost;
@@ -46,6 +54,10 @@ struct Config
 
     std::string mTeamName;
     std::string mSecret;
+
+    ExchangeLimits mLimits;
+
+    std::string mMetricsName;
 };
 
 }
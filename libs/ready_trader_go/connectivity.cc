@@ -31,8 +31,10 @@
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/system/error_code.hpp>
 
+#include "allocation.h"
 #include "connectivity.h"
 #include "error.h"
+#include "latency.h"
 #include "logging.h"
 
 namespace error = boost::asio::error;
@@ -75,6 +77,8 @@ void Connection::AsyncRead()
 
 void Connection::ReadSomeHandler(const boost::system::error_code& error, std::size_t size)
 {
+    RTG_ALLOCATION_SCOPE();
+
     if (error)
     {
         if (error == error::eof)
@@ -128,6 +132,7 @@ void Connection::ReadSomeHandler(const boost::system::error_code& error, std::si
 void Connection::Send()
 {
     mIsSending = true;
+    RTG_LATENCY_STAMP(SEND);
     mSocket.async_write_some(mOutBuffer.data(),
                              [this](auto& err, auto sz) { WriteSomeHandler(err, sz); });
 }
@@ -160,6 +165,7 @@ void Connection::SendMessage(unsigned char messageType, const ISerialisable& ser
     data[MESSAGE_TYPE_OFFSET] = messageType;
     serialisable.Serialise(data + MESSAGE_HEADER_SIZE);
     mOutBuffer.commit(size);
+    RTG_LATENCY_QUEUED();
     if (!mIsSending)
     {
         Send(mode);
@@ -188,6 +194,8 @@ void Connection::WriteSomeHandler(const boost::system::error_code& error, std::s
 
     if (mOutBuffer.size() > 0)
     {
+        // Messages queued while the last write was in flight go out now.
+        RTG_LATENCY_STAMP(SEND);
         mSocket.async_write_some(
             mOutBuffer.data(), [this](auto& err, auto sz) { WriteSomeHandler(err, sz); });
     }
@@ -222,10 +230,13 @@ void Subscription::AsyncReceive(unsigned long pos, std::weak_ptr<ISubscription>
         return;
     }
 
+    RTG_ALLOCATION_SCOPE();
+
     unsigned char* addr = ((unsigned char*)mRegion.get_address()) + pos;
 
     if (addr[0] != 0)
     {
+        RTG_LATENCY_STAMP_FRAME();
         const uint32_t* payload_size_ptr = (uint32_t*)(addr + FRAME_PAYLOAD_SIZE_OFFSET);
         const std::size_t payloadSize = boost::endian::big_to_native(*payload_size_ptr);
         ReceiveFromHandler(addr + FRAME_HEADER_SIZE, payloadSize);
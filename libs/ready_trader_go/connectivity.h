@@ -49,7 +49,7 @@ constexpr std::size_t MESSAGE_TYPE_OFFSET = 2;
 constexpr std::size_t FRAME_PAYLOAD_SIZE_OFFSET = 4;
 constexpr std::size_t FRAME_HEADER_SIZE = 8;
 constexpr std::size_t FRAME_SIZE = 128;
-constexpr std::size_t SUBSCRIPTION_TRANSPORT_BUFFER_SIZE = 8182;
+constexpr std::size_t SUBSCRIPTION_TRANSPORT_BUFFER_SIZE = 8192;
 
 
 class Connection : public IConnection
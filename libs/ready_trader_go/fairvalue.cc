@@ -0,0 +1,67 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "fairvalue.h"
+
+namespace ReadyTraderGo {
+
+bool FairValue::Update(Instrument instrument,
+                       unsigned long askPrice,
+                       unsigned long askVolume,
+                       unsigned long bidPrice,
+                       unsigned long bidVolume)
+{
+    const auto i = static_cast<std::size_t>(instrument);
+    mTop.mAskPrices[i] = askPrice;
+    mTop.mAskVolumes[i] = askVolume;
+    mTop.mBidPrices[i] = bidPrice;
+    mTop.mBidVolumes[i] = bidVolume;
+
+    if (askPrice == 0 || bidPrice == 0)
+    {
+        // Keep the last microprice for a one-sided book; the basis and fair
+        // value carry on from it.
+        return false;
+    }
+    const unsigned long totalVolume = askVolume + bidVolume;
+    mMicroprices[i] = (totalVolume != 0) ? (bidPrice * askVolume + askPrice * bidVolume) / totalVolume
+                                         : (askPrice + bidPrice) / 2;
+
+    const unsigned long future = mMicroprices[static_cast<std::size_t>(Instrument::FUTURE)];
+    const unsigned long etf = mMicroprices[static_cast<std::size_t>(Instrument::ETF)];
+    if (future == 0)
+    {
+        return false;
+    }
+    if (etf != 0)
+    {
+        const signed long sample = static_cast<signed long>(etf) - static_cast<signed long>(future);
+        mBasis = mHaveBasis ? mBasis + (sample - mBasis) / (1L << BASIS_SMOOTHING_SHIFT) : sample;
+        mHaveBasis = true;
+    }
+
+    mFairPrice = static_cast<unsigned long>(static_cast<signed long>(future) + mBasis);
+    const unsigned long moved = (mFairPrice > mTriggerPrice) ? mFairPrice - mTriggerPrice : mTriggerPrice - mFairPrice;
+    if (mTriggerPrice != 0 && moved < mTickSize)
+    {
+        return false;
+    }
+    mTriggerPrice = mFairPrice;
+    return true;
+}
+
+}
@@ -0,0 +1,88 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FAIRVALUE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FAIRVALUE_H
+
+#include <array>
+#include <cstddef>
+
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The best bid and ask of both instruments, indexed by Instrument, in a
+// single cache line.
+struct alignas(64) TopOfBook
+{
+    std::array<unsigned long, 2> mAskPrices = {};
+    std::array<unsigned long, 2> mAskVolumes = {};
+    std::array<unsigned long, 2> mBidPrices = {};
+    std::array<unsigned long, 2> mBidVolumes = {};
+};
+
+static_assert(sizeof(TopOfBook) == 64, "TopOfBook should fill exactly one cache line");
+
+// Fair value of the ETF from both order books. The future leads, so the
+// fair value is the future's microprice plus a smoothed ETF/future basis:
+//
+//   microprice = (bid * askVolume + ask * bidVolume) / (askVolume + bidVolume)
+//   basis     += (etfMicroprice - futureMicroprice - basis) / 2^BASIS_SMOOTHING_SHIFT
+//
+// Update returns true only when the fair value has moved by at least a tick
+// since it last returned true, so callers can requote on that alone.
+class FairValue
+{
+public:
+    static constexpr int BASIS_SMOOTHING_SHIFT = 4;
+
+    explicit FairValue(unsigned long tickSize = 100) : mTickSize(tickSize) {}
+
+    void SetTickSize(unsigned long tickSize) { mTickSize = tickSize; }
+
+    bool Update(Instrument instrument,
+                unsigned long askPrice,
+                unsigned long askVolume,
+                unsigned long bidPrice,
+                unsigned long bidVolume);
+
+    // Zero until the future has had a two-sided book.
+    unsigned long FairPrice() const { return mFairPrice; }
+    signed long Basis() const { return mBasis; }
+    unsigned long Microprice(Instrument instrument) const { return mMicroprices[static_cast<std::size_t>(instrument)]; }
+    unsigned long Spread(Instrument instrument) const;
+    const TopOfBook& Top() const { return mTop; }
+
+private:
+    TopOfBook mTop;
+    std::array<unsigned long, 2> mMicroprices = {};
+    signed long mBasis = 0;
+    bool mHaveBasis = false;
+    unsigned long mFairPrice = 0;
+    unsigned long mTriggerPrice = 0;
+    unsigned long mTickSize;
+};
+
+inline unsigned long FairValue::Spread(Instrument instrument) const
+{
+    const auto i = static_cast<std::size_t>(instrument);
+    return (mTop.mAskPrices[i] != 0 && mTop.mBidPrices[i] != 0) ? mTop.mAskPrices[i] - mTop.mBidPrices[i] : 0;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FAIRVALUE_H
@@ -0,0 +1,161 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstdlib>
+
+#include "hedgemanager.h"
+#include "logging.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_HEDGE, "HEDGE")
+
+namespace ReadyTraderGo {
+
+signed long HedgeManager::RelativePosition() const
+{
+    return mTrader.GetOrderManager().Position() + mFuturePosition;
+}
+
+void HedgeManager::OnOrderFilled()
+{
+    UpdateDeadline();
+    Rebalance();
+}
+
+void HedgeManager::OnFutureOrderBook(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                                     const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    mAskPrices = askPrices;
+    mAskVolumes = askVolumes;
+    mBidPrices = bidPrices;
+    mBidVolumes = bidVolumes;
+    Rebalance();
+}
+
+void HedgeManager::OnHedgeFilled(unsigned long clientOrderId, unsigned long, unsigned long volume)
+{
+    if (clientOrderId != mPendingId)
+    {
+        return;
+    }
+
+    // A hedge that found nothing to trade with comes back with zero volume
+    // and is retried on the next order book.
+    mPendingId = 0;
+    if (volume != 0)
+    {
+        mFuturePosition += (mPendingSide == Side::BUY) ? static_cast<signed long>(volume)
+                                                       : -static_cast<signed long>(volume);
+        UpdateDeadline();
+        Rebalance();
+    }
+}
+
+void HedgeManager::OnError(unsigned long clientOrderId)
+{
+    if (clientOrderId != mPendingId)
+    {
+        return;
+    }
+
+    // Nothing was traded. Retrying at once would most likely meet the same
+    // error, so wait for the next order book as for a hedge that missed.
+    RLOG(LG_HEDGE, LogLevel::LL_WARNING) << "hedge order " << clientOrderId << " rejected: relative position "
+                                         << RelativePosition();
+    mPendingId = 0;
+}
+
+void HedgeManager::Rebalance()
+{
+    const signed long relative = RelativePosition();
+    if (mPendingId != 0 || std::labs(relative) <= MAX_UNHEDGED_LOTS)
+    {
+        return;
+    }
+
+    const Side side = (relative > 0) ? Side::SELL : Side::BUY;
+    const unsigned long volume = static_cast<unsigned long>(std::labs(relative));
+    const unsigned long tickSize = mTrader.GetExchangeLimits().mTickSize;
+    unsigned long price;
+    if (mDeadlinePassed)
+    {
+        price = (side == Side::SELL) ? (MINIMUM_BID + tickSize) / tickSize * tickSize
+                                     : MAXIMUM_ASK / tickSize * tickSize;
+    }
+    else
+    {
+        price = LimitPrice(side, volume);
+        if (price == 0)
+        {
+            return;
+        }
+    }
+
+    mPendingId = mTrader.NextClientOrderId();
+    mPendingSide = side;
+    mTrader.SendHedgeOrder(mPendingId, side, price, volume);
+}
+
+void HedgeManager::UpdateDeadline()
+{
+    // Mirror the exchange: its timer starts when the relative position
+    // leaves the band and stops when it comes back in.
+    const signed long relative = RelativePosition();
+    const int sign = (relative > MAX_UNHEDGED_LOTS) ? 1 : (relative < -MAX_UNHEDGED_LOTS) ? -1 : 0;
+    if (sign == mDeadlineSign)
+    {
+        return;
+    }
+
+    mDeadlineSign = sign;
+    mDeadlinePassed = false;
+    mDeadlineTimer.Cancel();
+    if (sign == 0)
+    {
+        return;
+    }
+
+    mDeadlineTimer.ExpiresAfter(UNHEDGED_LOTS_TIME_LIMIT - HEDGE_DEADLINE_MARGIN);
+}
+
+void HedgeManager::DeadlineHandler()
+{
+    RLOG(LG_HEDGE, LogLevel::LL_WARNING) << "unhedged lots deadline approaching: relative position "
+                                         << RelativePosition() << ", hedging at any price";
+    mDeadlinePassed = true;
+    Rebalance();
+}
+
+unsigned long HedgeManager::LimitPrice(Side side, unsigned long volume) const
+{
+    // Walk the side of the book the hedge trades against until there is
+    // enough volume to fill it; the last price reached is the limit.
+    const auto& prices = (side == Side::SELL) ? mBidPrices : mAskPrices;
+    const auto& volumes = (side == Side::SELL) ? mBidVolumes : mAskVolumes;
+
+    unsigned long available = 0;
+    unsigned long price = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && prices[i] != 0 && available < volume; ++i)
+    {
+        available += volumes[i];
+        price = prices[i];
+    }
+    return price;
+}
+
+}
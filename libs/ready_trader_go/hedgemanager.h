@@ -0,0 +1,100 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEMANAGER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEMANAGER_H
+
+#include <array>
+#include <chrono>
+
+#include <boost/asio/io_context.hpp>
+
+#include "baseautotrader.h"
+#include "scheduler.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The exchange's unhedged lots rule (see unhedged_lots.py): the ETF and
+// future positions may differ by up to MAX_UNHEDGED_LOTS for as long as we
+// like, but by more than that for at most UNHEDGED_LOTS_TIME_LIMIT.
+constexpr long MAX_UNHEDGED_LOTS = 10;
+constexpr std::chrono::seconds UNHEDGED_LOTS_TIME_LIMIT{60};
+
+// Keeps the future position within MAX_UNHEDGED_LOTS of the ETF position
+// while sending as few hedge orders as possible:
+//   * fills are netted, and nothing is hedged while the difference is within
+//     MAX_UNHEDGED_LOTS;
+//   * beyond that, the whole difference is hedged in one order priced at the
+//     level of the future book deep enough to fill it, rather than at the
+//     extreme price;
+//   * only one hedge is in flight at a time, and a hedge that misses or is
+//     rejected is retried on the next future order book update;
+//   * a timer mirrors the exchange's, and once it gets within
+//     HEDGE_DEADLINE_MARGIN of the limit hedges go at the extreme price.
+class HedgeManager
+{
+public:
+    static constexpr std::chrono::seconds HEDGE_DEADLINE_MARGIN{10};
+
+    HedgeManager(BaseAutoTrader& trader, boost::asio::io_context& context)
+        : mTrader(trader), mDeadlineTimer(context, [this] { DeadlineHandler(); }) {}
+
+    // Call after every ETF fill, once the order manager has applied it.
+    void OnOrderFilled();
+
+    void OnFutureOrderBook(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                           const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes);
+
+    void OnHedgeFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume);
+
+    // Call for every error message, whether from the exchange or a local
+    // reject; only one for the hedge in flight matters.
+    void OnError(unsigned long clientOrderId);
+
+    // Future position (in lots) from confirmed hedges.
+    signed long FuturePosition() const { return mFuturePosition; }
+
+    // ETF position plus future position, which the exchange's rule applies to.
+    signed long RelativePosition() const;
+
+private:
+    void Rebalance();
+    void UpdateDeadline();
+    void DeadlineHandler();
+    unsigned long LimitPrice(Side side, unsigned long volume) const;
+
+    BaseAutoTrader& mTrader;
+    DeadlineTimer mDeadlineTimer;
+
+    std::array<unsigned long, TOP_LEVEL_COUNT> mAskPrices = {};
+    std::array<unsigned long, TOP_LEVEL_COUNT> mAskVolumes = {};
+    std::array<unsigned long, TOP_LEVEL_COUNT> mBidPrices = {};
+    std::array<unsigned long, TOP_LEVEL_COUNT> mBidVolumes = {};
+
+    signed long mFuturePosition = 0;
+    unsigned long mPendingId = 0;
+    Side mPendingSide = Side::SELL;
+    int mDeadlineSign = 0;              // Which side of the band the exchange's timer is running for.
+    bool mDeadlinePassed = false;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEMANAGER_H
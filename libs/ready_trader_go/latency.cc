@@ -0,0 +1,164 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifdef RTG_LATENCY_TRACING
+
+#include <algorithm>
+#include <cmath>
+
+#include "latency.h"
+#include "logging.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_LAT, "LAT")
+
+namespace ReadyTraderGo {
+
+std::size_t LatencyHistogram::BucketIndex(std::uint64_t value) noexcept
+{
+    if (value < SUB_BUCKETS)
+    {
+        return static_cast<std::size_t>(value);
+    }
+    // Values of magnitude 2^m are split into SUB_BUCKETS buckets by their top
+    // SUB_BUCKET_BITS + 1 bits.
+    const unsigned magnitude = 63 - __builtin_clzll(value);
+    const unsigned shift = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+}
+
+std::uint64_t LatencyHistogram::BucketHighest(std::size_t index) noexcept
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+    const unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    const std::uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowest + (std::uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(std::uint64_t value) noexcept
+{
+    value = std::min(value, (std::uint64_t(1) << MAX_VALUE_BITS) - 1);
+    ++mCounts[BucketIndex(value)];
+    ++mCount;
+    mMax = std::max(mMax, value);
+}
+
+std::uint64_t LatencyHistogram::Percentile(double percentile) const noexcept
+{
+    if (mCount == 0)
+    {
+        return 0;
+    }
+    const auto wanted = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(mCount)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += mCounts[i];
+        if (seen >= std::max<std::uint64_t>(wanted, 1))
+        {
+            return std::min(BucketHighest(i), mMax);
+        }
+    }
+    return mMax;
+}
+
+void LatencyTracer::StampDecode(unsigned long sequenceNumber) noexcept
+{
+    const std::uint64_t frame = mStamps[static_cast<std::size_t>(LatencyPoint::FRAME)];
+    if (frame == 0)
+    {
+        return;
+    }
+    const std::uint64_t now = Clock::Cycles();
+    mStamps[static_cast<std::size_t>(LatencyPoint::DECODE)] = now;
+    mSequenceNumber = sequenceNumber;
+    mDecoded = true;
+    mInStrategy = false;
+    mQueued = false;
+    mSent = false;
+    mFrameToDecode.Record(now - frame);
+}
+
+void LatencyTracer::Stamp(LatencyPoint point) noexcept
+{
+    if (!mDecoded || (point == LatencyPoint::SEND && (!mQueued || mSent)))
+    {
+        return;
+    }
+
+    const std::uint64_t now = Clock::Cycles();
+    mStamps[static_cast<std::size_t>(point)] = now;
+    switch (point)
+    {
+    case LatencyPoint::STRATEGY_ENTRY:
+        mDecodeToStrategy.Record(now - mStamps[static_cast<std::size_t>(LatencyPoint::DECODE)]);
+        mInStrategy = true;
+        break;
+    case LatencyPoint::STRATEGY_EXIT:
+        mStrategyTime.Record(now - mStamps[static_cast<std::size_t>(LatencyPoint::STRATEGY_ENTRY)]);
+        mInStrategy = false;
+        // Anything sent from here on was not caused by this update.
+        mDecoded = mQueued;
+        break;
+    case LatencyPoint::SEND:
+    {
+        const std::uint64_t tickToTrade = now - mStamps[static_cast<std::size_t>(LatencyPoint::FRAME)];
+        mTickToTrade.Record(tickToTrade);
+        if (tickToTrade > mSlowest)
+        {
+            mSlowest = tickToTrade;
+            mSlowestSequenceNumber = mSequenceNumber;
+        }
+        mSent = true;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LatencyTracer::Dump() const
+{
+    const auto nanos = [](std::uint64_t cycles) {
+        return static_cast<unsigned long>(Clock::CycleIntervalToNanoseconds(cycles));
+    };
+
+    const auto dump = [&nanos](const char* name, const LatencyHistogram& histogram) {
+        RLOG(LG_LAT, LogLevel::LL_INFO) << name << ": count=" << histogram.Count()
+                                        << " p50=" << nanos(histogram.Percentile(50.0))
+                                        << " p90=" << nanos(histogram.Percentile(90.0))
+                                        << " p99=" << nanos(histogram.Percentile(99.0))
+                                        << " p99.9=" << nanos(histogram.Percentile(99.9))
+                                        << " max=" << nanos(histogram.Max()) << " (ns)";
+    };
+
+    dump("frame to decode", mFrameToDecode);
+    dump("decode to strategy", mDecodeToStrategy);
+    dump("in strategy", mStrategyTime);
+    dump("tick to trade", mTickToTrade);
+    if (mTickToTrade.Count() != 0)
+    {
+        RLOG(LG_LAT, LogLevel::LL_INFO) << "slowest tick to trade was " << nanos(mSlowest)
+                                        << " ns, for order book sequence number " << mSlowestSequenceNumber;
+    }
+}
+
+}
+
+#endif
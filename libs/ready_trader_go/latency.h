@@ -0,0 +1,164 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LATENCY_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LATENCY_H
+
+// Tick-to-trade latency tracing. Build with RTG_LATENCY_TRACING (the CMake
+// option of the same name) to enable it; otherwise the RTG_LATENCY_ macros
+// expand to nothing and none of the code below is compiled.
+//
+// Each order book update is traced from the moment its frame is seen in the
+// subscription to the first order message written to the exchange because
+// of it, by reading the time stamp counter at these points:
+//
+//   FRAME           the subscription sees a new frame;
+//   DECODE          the frame has been decoded into an order book update;
+//   STRATEGY_ENTRY  the strategy's order book handler is called;
+//   STRATEGY_EXIT   the handler returns; and
+//   SEND            the first write that carries a message the handler
+//                   queued is issued, which may be after the handler
+//                   returns if an earlier write was still in flight.
+//
+// A trace whose handler queued nothing ends at STRATEGY_EXIT, so messages
+// sent later because of a fill or a timer are not charged to it.
+//
+// The intervals between them go into log-linear (HDR-style) histograms,
+// which are written to the log when the application's run loop ends, or on
+// SIGUSR1. There is one tracer per thread, so traders sharing a process
+// each get their own.
+
+#ifdef RTG_LATENCY_TRACING
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+enum class LatencyPoint : unsigned char
+{
+    FRAME,
+    DECODE,
+    STRATEGY_ENTRY,
+    STRATEGY_EXIT,
+    SEND
+};
+
+constexpr std::size_t LATENCY_POINT_COUNT = 5;
+
+// Counts of values in buckets whose width grows with the value, so that
+// every value is held to within 1 part in 2^SUB_BUCKET_BITS whatever its
+// size, in a fixed amount of memory.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr unsigned MAX_VALUE_BITS = 48;
+
+    void Record(std::uint64_t value) noexcept;
+
+    std::uint64_t Count() const noexcept { return mCount; }
+    std::uint64_t Max() const noexcept { return mMax; }
+
+    // The highest value equivalent to the one at the given percentile.
+    std::uint64_t Percentile(double percentile) const noexcept;
+
+private:
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static std::size_t BucketIndex(std::uint64_t value) noexcept;
+    static std::uint64_t BucketHighest(std::size_t index) noexcept;
+
+    std::array<std::uint64_t, BUCKET_COUNT> mCounts = {};
+    std::uint64_t mCount = 0;
+    std::uint64_t mMax = 0;
+};
+
+class LatencyTracer
+{
+public:
+    static LatencyTracer& Local()
+    {
+        static thread_local LatencyTracer tracer;
+        return tracer;
+    }
+
+    // A new frame starts a new trace, abandoning any earlier one.
+    void StampFrame() noexcept
+    {
+        mStamps[static_cast<std::size_t>(LatencyPoint::FRAME)] = Clock::Cycles();
+        mDecoded = false;
+        mInStrategy = false;
+        mQueued = false;
+        mSent = false;
+    }
+
+    // Only frames carrying an order book update are traced further.
+    void StampDecode(unsigned long sequenceNumber) noexcept;
+    void Stamp(LatencyPoint point) noexcept;
+
+    // An order message has been queued for writing.
+    void MarkQueued() noexcept
+    {
+        if (mInStrategy)
+        {
+            mQueued = true;
+        }
+    }
+
+    // Write every histogram to the log.
+    void Dump() const;
+
+private:
+    std::array<std::uint64_t, LATENCY_POINT_COUNT> mStamps = {};
+    unsigned long mSequenceNumber = 0;
+    bool mDecoded = false;                      // The trace is open.
+    bool mInStrategy = false;
+    bool mQueued = false;                       // The handler queued a message.
+    bool mSent = false;
+
+    LatencyHistogram mFrameToDecode;
+    LatencyHistogram mDecodeToStrategy;
+    LatencyHistogram mStrategyTime;
+    LatencyHistogram mTickToTrade;              // FRAME to SEND.
+    std::uint64_t mSlowest = 0;
+    unsigned long mSlowestSequenceNumber = 0;
+};
+
+}
+
+#define RTG_LATENCY_STAMP_FRAME() ::ReadyTraderGo::LatencyTracer::Local().StampFrame()
+#define RTG_LATENCY_STAMP_DECODE(sequenceNumber) ::ReadyTraderGo::LatencyTracer::Local().StampDecode(sequenceNumber)
+#define RTG_LATENCY_STAMP(point) ::ReadyTraderGo::LatencyTracer::Local().Stamp(::ReadyTraderGo::LatencyPoint::point)
+#define RTG_LATENCY_QUEUED() ::ReadyTraderGo::LatencyTracer::Local().MarkQueued()
+#define RTG_LATENCY_DUMP() ::ReadyTraderGo::LatencyTracer::Local().Dump()
+
+#else
+
+#define RTG_LATENCY_STAMP_FRAME() do {} while (false)
+#define RTG_LATENCY_STAMP_DECODE(sequenceNumber) do {} while (false)
+#define RTG_LATENCY_STAMP(point) do {} while (false)
+#define RTG_LATENCY_QUEUED() do {} while (false)
+#define RTG_LATENCY_DUMP() do {} while (false)
+
+#endif
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LATENCY_H
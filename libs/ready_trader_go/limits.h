@@ -0,0 +1,57 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LIMITS_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LIMITS_H
+
+#include <cstddef>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace ReadyTraderGo {
+
+// The limits enforced by the exchange (see the "Limits" and "Instrument"
+// sections of exchange.json). The defaults match the competition settings
+// and can be overridden by an optional "Limits" section in the autotrader
+// configuration.
+struct ExchangeLimits
+{
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        mActiveOrderCountLimit = tree.get<std::size_t>("Limits.ActiveOrderCountLimit", mActiveOrderCountLimit);
+        mActiveVolumeLimit = tree.get<unsigned long>("Limits.ActiveVolumeLimit", mActiveVolumeLimit);
+        mMessageFrequencyInterval = tree.get<double>("Limits.MessageFrequencyInterval", mMessageFrequencyInterval);
+        mMessageFrequencyLimit = tree.get<std::size_t>("Limits.MessageFrequencyLimit", mMessageFrequencyLimit);
+        mPositionLimit = tree.get<long>("Limits.PositionLimit", mPositionLimit);
+        mEtfClamp = tree.get<double>("Instrument.EtfClamp", mEtfClamp);
+        // The exchange configures the tick size in dollars.
+        const double tickSize = tree.get<double>("Instrument.TickSize", mTickSize / 100.0);
+        mTickSize = static_cast<unsigned long>(tickSize * 100.0 + 0.5);
+    }
+
+    std::size_t mActiveOrderCountLimit = 10;
+    unsigned long mActiveVolumeLimit = 200;
+    double mMessageFrequencyInterval = 1.0;
+    std::size_t mMessageFrequencyLimit = 50;
+    long mPositionLimit = 100;
+    double mEtfClamp = 0.002;
+    unsigned long mTickSize = 100; // in cents
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LIMITS_H
@@ -54,7 +54,7 @@ std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, LogLevel lv
 
 #define RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(loggerName, channelName)\
     BOOST_LOG_INLINE_GLOBAL_LOGGER_CTOR_ARGS(loggerName,\
-        boost::log::sources::severity_channel_logger<ReadyTraderGo::LogLevel>,\
+        boost::log::sources::severity_channel_logger_mt<ReadyTraderGo::LogLevel>,\
         (boost::log::keywords::channel = (channelName)));
 
 #define RLOG(loggerName, logLevel) BOOST_LOG_SEV(loggerName::get(), (logLevel))
@@ -0,0 +1,72 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <new>
+
+#include <unistd.h>
+
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include "error.h"
+#include "logging.h"
+#include "metrics.h"
+
+namespace interprocess = boost::interprocess;
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_MET, "METRICS")
+
+namespace ReadyTraderGo {
+
+struct MetricsPublisher::Mapping
+{
+    interprocess::shared_memory_object mObject;
+    interprocess::mapped_region mRegion;
+};
+
+MetricsPublisher::MetricsPublisher(const std::string& name) : mName(name)
+{
+    interprocess::shared_memory_object::remove(mName.c_str());
+    try
+    {
+        interprocess::shared_memory_object object{interprocess::create_only, mName.c_str(), interprocess::read_write};
+        object.truncate(sizeof(MetricsSegment));
+        interprocess::mapped_region region{object, interprocess::read_write, 0, sizeof(MetricsSegment)};
+        mMapping = std::make_unique<Mapping>(Mapping{std::move(object), std::move(region)});
+    }
+    catch (const interprocess::interprocess_exception& e)
+    {
+        RLOG(LG_MET, LogLevel::LL_ERROR) << "failed to create metrics segment '" << mName << "': " << e.what();
+        throw ReadyTraderGoError("failed to create metrics segment '" + mName + "': " + e.what());
+    }
+
+    mSegment = new (mMapping->mRegion.get_address()) MetricsSegment();
+    mSegment->mProcessId = static_cast<std::uint32_t>(::getpid());
+    std::copy_n(mName.begin(), std::min(mName.size(), METRICS_NAME_SIZE - 1), mSegment->mName.begin());
+    RLOG(LG_MET, LogLevel::LL_INFO) << "publishing metrics in shared memory segment '" << mName << "'";
+}
+
+MetricsPublisher::~MetricsPublisher()
+{
+    mSegment->~MetricsSegment();
+    mMapping.reset();
+    interprocess::shared_memory_object::remove(mName.c_str());
+}
+
+}
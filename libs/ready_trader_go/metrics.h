@@ -0,0 +1,124 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_METRICS_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ReadyTraderGo {
+
+// The first bytes of every metrics segment, and its layout version. Fields
+// are only ever added at the end of MetricsSegment; anything else means a
+// new version.
+constexpr std::uint32_t METRICS_MAGIC = 0x4d475452;        // "RTGM"
+constexpr std::uint32_t METRICS_VERSION = 1;
+
+// Message counters are indexed by MessageType.
+constexpr std::size_t METRICS_MESSAGE_TYPES = 16;
+
+constexpr std::size_t METRICS_NAME_SIZE = 64;
+
+// Counters published by a running trader for an external monitor (see
+// metricsmon.cc). There is exactly one writer, the trader's own thread, so
+// every update is a relaxed load and store rather than a locked
+// read-modify-write, and reading them costs the trader nothing beyond the
+// cache lines they share.
+struct MetricsSegment
+{
+    using Counter = std::atomic<std::uint64_t>;
+    using Gauge = std::atomic<std::int64_t>;
+
+    MetricsSegment() = default;
+    MetricsSegment(const MetricsSegment&) = delete;
+    MetricsSegment& operator=(const MetricsSegment&) = delete;
+
+    std::uint32_t mMagic = METRICS_MAGIC;
+    std::uint32_t mVersion = METRICS_VERSION;
+    std::uint32_t mSize = sizeof(MetricsSegment);
+    std::uint32_t mProcessId = 0;
+    std::array<char, METRICS_NAME_SIZE> mName = {};
+
+    // ReadyTraderGo::Clock time of the last message received, in
+    // nanoseconds. Clock is anchored to CLOCK_MONOTONIC_RAW, so another
+    // process can tell how long ago that was.
+    alignas(64) Gauge mHeartbeat{0};
+
+    alignas(64) std::array<Counter, METRICS_MESSAGE_TYPES> mMessagesIn = {};
+    alignas(64) std::array<Counter, METRICS_MESSAGE_TYPES> mMessagesOut = {};
+
+    alignas(64) Counter mRingOverruns{0};          // Trade ticks overwritten before they were read.
+    Counter mSequenceGaps{0};                      // Information messages missed, on any stream.
+    Counter mLocalRejects{0};                      // Orders stopped by the risk gate.
+    Counter mExchangeErrors{0};
+
+    alignas(64) Gauge mHeldMessages{0};            // Order messages waiting for rate budget.
+    Gauge mRateBudget{0};                          // Messages that could be sent now in the normal lane.
+    Gauge mActiveOrders{0};
+    Gauge mEtfPosition{0};
+    Gauge mFuturePosition{0};
+
+    Counter mSequenceDrops{0};                     // Information messages dropped as duplicate or out of order.
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "metrics must be lock free to be shared");
+
+inline void Increment(MetricsSegment::Counter& counter, std::uint64_t by = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+inline void Publish(MetricsSegment::Gauge& gauge, std::int64_t value) noexcept
+{
+    gauge.store(value, std::memory_order_relaxed);
+}
+
+// The name of the shared memory segment for the given trader.
+inline std::string MetricsSegmentName(const std::string& teamName)
+{
+    return "rtg-metrics-" + teamName;
+}
+
+// Creates a named shared memory segment holding a MetricsSegment, replacing
+// any left behind by an earlier run, and removes it again on destruction.
+class MetricsPublisher
+{
+public:
+    explicit MetricsPublisher(const std::string& name);
+    ~MetricsPublisher();
+
+    MetricsPublisher(const MetricsPublisher&) = delete;
+    MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+
+    MetricsSegment& Segment() noexcept { return *mSegment; }
+
+private:
+    struct Mapping;
+
+    std::string mName;
+    std::unique_ptr<Mapping> mMapping;
+    MetricsSegment* mSegment = nullptr;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_METRICS_H
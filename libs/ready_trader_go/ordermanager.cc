@@ -0,0 +1,155 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include "ordermanager.h"
+
+namespace ReadyTraderGo {
+
+void OrderManager::OnAmend(unsigned long clientOrderId, unsigned long) noexcept
+{
+    OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order != nullptr && (order->mState == OrderState::LIVE || order->mState == OrderState::PENDING_NEW))
+    {
+        order->mState = OrderState::PENDING_AMEND;
+    }
+}
+
+void OrderManager::OnCancel(unsigned long clientOrderId) noexcept
+{
+    OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order != nullptr && order->mState != OrderState::DONE)
+    {
+        order->mState = OrderState::PENDING_CANCEL;
+    }
+}
+
+bool OrderManager::OnInsert(unsigned long clientOrderId,
+                            Side side,
+                            unsigned long price,
+                            unsigned long volume) noexcept
+{
+    if (OrderRecord* previous = mOrders.Find(clientOrderId))
+    {
+        Finish(*previous);
+    }
+    OrderRecord* order = mOrders.Insert(clientOrderId, side, price, volume);
+    if (order == nullptr)
+    {
+        return false;
+    }
+    order->mState = OrderState::PENDING_NEW;
+    mLiveVolume[static_cast<std::size_t>(side)] += volume;
+    ++mActiveOrderCount;
+    return true;
+}
+
+bool OrderManager::OnError(unsigned long clientOrderId) noexcept
+{
+    OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order == nullptr)
+    {
+        return false;
+    }
+
+    if (order->mState == OrderState::DONE)
+    {
+        return false;
+    }
+    if (!order->mAcknowledged)
+    {
+        Finish(*order);
+        return true;
+    }
+    if (order->mState == OrderState::PENDING_AMEND)
+    {
+        order->mState = OrderState::LIVE;
+    }
+    return false;
+}
+
+void OrderManager::OnOrderFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume) noexcept
+{
+    OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order == nullptr)
+    {
+        return;
+    }
+    order->mAcknowledged = true;
+    order->mFilledVolume += volume;
+    order->mFilledValue += price * volume;
+    mPosition += (order->mSide == Side::BUY) ? static_cast<signed long>(volume) : -static_cast<signed long>(volume);
+    if (order->mState != OrderState::DONE)
+    {
+        SetRemainingVolume(*order, order->mRemainingVolume - std::min(volume, order->mRemainingVolume));
+    }
+}
+
+void OrderManager::OnOrderStatus(unsigned long clientOrderId,
+                                 unsigned long,
+                                 unsigned long remainingVolume,
+                                 signed long fees) noexcept
+{
+    OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order == nullptr || order->mState == OrderState::DONE)
+    {
+        return;
+    }
+
+    order->mAcknowledged = true;
+    order->mFees = fees;
+    if (remainingVolume == 0)
+    {
+        Finish(*order);
+        return;
+    }
+
+    SetRemainingVolume(*order, remainingVolume);
+    if (order->mState == OrderState::PENDING_NEW || order->mState == OrderState::PENDING_AMEND)
+    {
+        order->mState = OrderState::LIVE;
+    }
+}
+
+void OrderManager::RetireIfDone(unsigned long clientOrderId) noexcept
+{
+    const OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order != nullptr && order->mState == OrderState::DONE)
+    {
+        mOrders.Retire(clientOrderId);
+    }
+}
+
+void OrderManager::SetRemainingVolume(OrderRecord& order, unsigned long remainingVolume) noexcept
+{
+    auto& live = mLiveVolume[static_cast<std::size_t>(order.mSide)];
+    live = live - order.mRemainingVolume + remainingVolume;
+    order.mRemainingVolume = remainingVolume;
+}
+
+void OrderManager::Finish(OrderRecord& order) noexcept
+{
+    if (order.mState != OrderState::DONE)
+    {
+        SetRemainingVolume(order, 0);
+        order.mState = OrderState::DONE;
+        --mActiveOrderCount;
+    }
+}
+
+}
@@ -0,0 +1,122 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERMANAGER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERMANAGER_H
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "orderregistry.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// Tracks every order sent by an auto-trader through its life:
+//
+//   PENDING_NEW -> LIVE <-> PENDING_AMEND
+//                   |
+//                   +-> PENDING_CANCEL -> DONE
+//
+// Any state may move to DONE when the exchange reports no remaining volume.
+// Whether the exchange has accepted the insert is tracked apart from these
+// states, since an amend or cancel may be sent before it has: an error for
+// an order that has not been acknowledged is the insert being rejected, and
+// finishes the order whatever state it is in.
+//
+// Records are kept in a flat OrderRegistry so no update allocates.
+class OrderManager
+{
+public:
+    // Requests sent to the exchange
+    void OnAmend(unsigned long clientOrderId, unsigned long volume) noexcept;
+    void OnCancel(unsigned long clientOrderId) noexcept;
+    // OnInsert returns false, and records nothing, if the registry has no
+    // room for the order; it must not then be sent.
+    bool OnInsert(unsigned long clientOrderId, Side side, unsigned long price, unsigned long volume) noexcept;
+
+    // Messages received from the exchange. OnError returns true if the error
+    // finished the order (i.e. the insert was rejected).
+    bool OnError(unsigned long clientOrderId) noexcept;
+    void OnOrderFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume) noexcept;
+    void OnOrderStatus(unsigned long clientOrderId,
+                       unsigned long fillVolume,
+                       unsigned long remainingVolume,
+                       signed long fees) noexcept;
+
+    // Release the record of a finished order.
+    void RetireIfDone(unsigned long clientOrderId) noexcept;
+
+    const OrderRecord* Find(unsigned long clientOrderId) const noexcept { return mOrders.Find(clientOrderId); }
+    // The highest buy or lowest sell price among orders that the exchange
+    // will still hold when the next message reaches it (so not those with a
+    // cancel on the way), or zero if there are none.
+    unsigned long BestPrice(Side side) const noexcept;
+    bool IsActive(unsigned long clientOrderId) const noexcept;
+    unsigned long RestingPrice(unsigned long clientOrderId) const noexcept;
+
+    // Number of orders, and lots per side, that count against the exchange's
+    // active order and active volume limits.
+    std::size_t ActiveOrderCount() const noexcept { return mActiveOrderCount; }
+    unsigned long LiveVolume(Side side) const noexcept { return mLiveVolume[static_cast<std::size_t>(side)]; }
+    unsigned long LiveVolume() const noexcept { return mLiveVolume[0] + mLiveVolume[1]; }
+
+    // Net position (in lots) from every fill the exchange has reported.
+    signed long Position() const noexcept { return mPosition; }
+
+    template<typename F>
+    void ForEach(F&& f) const { mOrders.ForEach(std::forward<F>(f)); }
+
+private:
+    void SetRemainingVolume(OrderRecord& order, unsigned long remainingVolume) noexcept;
+    void Finish(OrderRecord& order) noexcept;
+
+    OrderRegistry mOrders;
+    std::array<unsigned long, 2> mLiveVolume = {};
+    std::size_t mActiveOrderCount = 0;
+    signed long mPosition = 0;
+};
+
+inline bool OrderManager::IsActive(unsigned long clientOrderId) const noexcept
+{
+    const OrderRecord* order = mOrders.Find(clientOrderId);
+    return order != nullptr && order->mState != OrderState::DONE;
+}
+
+inline unsigned long OrderManager::BestPrice(Side side) const noexcept
+{
+    unsigned long best = 0;
+    mOrders.ForEach([side, &best](const OrderRecord& order) {
+        if (order.mSide == side && order.mState != OrderState::DONE && order.mState != OrderState::PENDING_CANCEL
+            && (best == 0 || (side == Side::BUY ? order.mPrice > best : order.mPrice < best)))
+        {
+            best = order.mPrice;
+        }
+    });
+    return best;
+}
+
+inline unsigned long OrderManager::RestingPrice(unsigned long clientOrderId) const noexcept
+{
+    const OrderRecord* order = mOrders.Find(clientOrderId);
+    return (order != nullptr && order->mState != OrderState::DONE) ? order->mPrice : 0;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERMANAGER_H
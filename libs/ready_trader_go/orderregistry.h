@@ -0,0 +1,182 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERREGISTRY_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERREGISTRY_H
+
+#include <array>
+#include <cstddef>
+
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+enum class OrderState : unsigned char
+{
+    FREE,
+    PENDING_NEW,
+    LIVE,
+    PENDING_AMEND,
+    PENDING_CANCEL,
+    DONE
+};
+
+struct OrderRecord
+{
+    // Average price paid (buy) or received (sell) per filled lot, including
+    // fees, or zero if nothing has been filled.
+    unsigned long CostBasis() const noexcept;
+
+    unsigned long mClientOrderId = 0;
+    unsigned long mPrice = 0;
+    unsigned long mVolume = 0;
+    unsigned long mRemainingVolume = 0;
+    unsigned long mFilledVolume = 0;
+    unsigned long mFilledValue = 0;
+    signed long mFees = 0;
+    Side mSide = Side::SELL;
+    OrderState mState = OrderState::FREE;
+    bool mAcknowledged = false;                 // The exchange has accepted the insert.
+};
+
+// A fixed-capacity table of orders. Each client order id maps directly onto
+// a slot (id modulo capacity), so lookup is a single index and the memory
+// used is constant for the life of the registry. Client order ids are
+// allocated sequentially, so two records only contend for a slot when more
+// than ORDER_REGISTRY_CAPACITY ids separate them. A finished (DONE) record
+// gives way to a newer order, but one that is still active never does:
+// Insert fails instead, and the caller must not send the new order.
+constexpr std::size_t ORDER_REGISTRY_CAPACITY = 256;
+
+class OrderRegistry
+{
+public:
+    static_assert((ORDER_REGISTRY_CAPACITY & (ORDER_REGISTRY_CAPACITY - 1)) == 0,
+                  "ORDER_REGISTRY_CAPACITY must be a power of two");
+
+    // Returns the new record, or nullptr if the slot holds an active order.
+    OrderRecord* Insert(unsigned long clientOrderId, Side side, unsigned long price, unsigned long volume) noexcept;
+    OrderRecord* Find(unsigned long clientOrderId) noexcept;
+    const OrderRecord* Find(unsigned long clientOrderId) const noexcept;
+    void Retire(unsigned long clientOrderId) noexcept;
+
+    std::size_t Size() const noexcept { return mSize; }
+
+    // Call f(record) for every record that is not free.
+    template<typename F>
+    void ForEach(F&& f) const;
+
+    // Retire every record for which pred(record) returns true.
+    template<typename P>
+    void RetireIf(P&& pred) noexcept;
+
+private:
+    static std::size_t SlotOf(unsigned long clientOrderId) noexcept
+    {
+        return clientOrderId & (ORDER_REGISTRY_CAPACITY - 1);
+    }
+
+    std::array<OrderRecord, ORDER_REGISTRY_CAPACITY> mRecords = {};
+    std::size_t mSize = 0;
+};
+
+inline unsigned long OrderRecord::CostBasis() const noexcept
+{
+    if (mFilledVolume == 0)
+    {
+        return 0;
+    }
+    const signed long value = static_cast<signed long>(mFilledValue) + ((mSide == Side::BUY) ? mFees : -mFees);
+    return (value > 0) ? static_cast<unsigned long>(value) / mFilledVolume : 0;
+}
+
+inline OrderRecord* OrderRegistry::Insert(unsigned long clientOrderId,
+                                          Side side,
+                                          unsigned long price,
+                                          unsigned long volume) noexcept
+{
+    OrderRecord& record = mRecords[SlotOf(clientOrderId)];
+    if (record.mState == OrderState::FREE)
+    {
+        ++mSize;
+    }
+    else if (record.mState != OrderState::DONE)
+    {
+        return nullptr;
+    }
+    record = OrderRecord{};
+    record.mClientOrderId = clientOrderId;
+    record.mPrice = price;
+    record.mVolume = volume;
+    record.mRemainingVolume = volume;
+    record.mSide = side;
+    record.mState = OrderState::LIVE;
+    return &record;
+}
+
+inline OrderRecord* OrderRegistry::Find(unsigned long clientOrderId) noexcept
+{
+    OrderRecord& record = mRecords[SlotOf(clientOrderId)];
+    return (record.mState != OrderState::FREE && record.mClientOrderId == clientOrderId) ? &record : nullptr;
+}
+
+inline const OrderRecord* OrderRegistry::Find(unsigned long clientOrderId) const noexcept
+{
+    const OrderRecord& record = mRecords[SlotOf(clientOrderId)];
+    return (record.mState != OrderState::FREE && record.mClientOrderId == clientOrderId) ? &record : nullptr;
+}
+
+inline void OrderRegistry::Retire(unsigned long clientOrderId) noexcept
+{
+    if (OrderRecord* record = Find(clientOrderId))
+    {
+        record->mState = OrderState::FREE;
+        --mSize;
+    }
+}
+
+template<typename F>
+void OrderRegistry::ForEach(F&& f) const
+{
+    std::size_t remaining = mSize;
+    for (std::size_t i = 0; remaining != 0 && i < ORDER_REGISTRY_CAPACITY; ++i)
+    {
+        if (mRecords[i].mState != OrderState::FREE)
+        {
+            f(mRecords[i]);
+            --remaining;
+        }
+    }
+}
+
+template<typename P>
+void OrderRegistry::RetireIf(P&& pred) noexcept
+{
+    for (std::size_t i = 0; mSize != 0 && i < ORDER_REGISTRY_CAPACITY; ++i)
+    {
+        OrderRecord& record = mRecords[i];
+        if (record.mState != OrderState::FREE && pred(static_cast<const OrderRecord&>(record)))
+        {
+            record.mState = OrderState::FREE;
+            --mSize;
+        }
+    }
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERREGISTRY_H
@@ -0,0 +1,175 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// A signed distance between two prices, in cents.
+class PriceDelta
+{
+public:
+    constexpr PriceDelta() = default;
+    constexpr explicit PriceDelta(signed long cents) : mCents(cents) {}
+
+    static constexpr PriceDelta Ticks(signed long ticks, unsigned long tickSize)
+    {
+        return PriceDelta(ticks * static_cast<signed long>(tickSize));
+    }
+
+    constexpr signed long Cents() const { return mCents; }
+
+    constexpr PriceDelta operator-() const { return PriceDelta(-mCents); }
+    constexpr PriceDelta operator+(PriceDelta other) const { return PriceDelta(mCents + other.mCents); }
+    constexpr PriceDelta operator-(PriceDelta other) const { return PriceDelta(mCents - other.mCents); }
+    constexpr PriceDelta operator/(signed long divisor) const { return PriceDelta(mCents / divisor); }
+
+private:
+    signed long mCents = 0;
+};
+
+// A price in cents. A default-constructed Price is "no price" (zero, as on
+// the wire); any other Price lies within [MINIMUM_BID, MAXIMUM_ASK]. Adding
+// a delta saturates at those bounds rather than wrapping, and a missing
+// price stays missing.
+class Price
+{
+public:
+    constexpr Price() = default;
+    constexpr explicit Price(unsigned long cents) : mCents(cents == 0 ? 0 : Clamp(static_cast<signed long>(cents))) {}
+
+    constexpr unsigned long Cents() const { return mCents; }
+    constexpr bool IsValid() const { return mCents != 0; }
+
+    // The nearest multiple of the tick size at or below (above) this price
+    // that is still a valid price.
+    constexpr Price RoundDown(unsigned long tickSize) const;
+    constexpr Price RoundUp(unsigned long tickSize) const;
+
+    constexpr Price operator+(PriceDelta delta) const;
+    constexpr Price operator-(PriceDelta delta) const { return *this + -delta; }
+    constexpr PriceDelta operator-(Price other) const
+    {
+        return PriceDelta(static_cast<signed long>(mCents) - static_cast<signed long>(other.mCents));
+    }
+
+    constexpr bool operator==(Price other) const { return mCents == other.mCents; }
+    constexpr bool operator!=(Price other) const { return mCents != other.mCents; }
+    constexpr bool operator<(Price other) const { return mCents < other.mCents; }
+    constexpr bool operator>(Price other) const { return mCents > other.mCents; }
+
+private:
+    static constexpr unsigned long Clamp(signed long cents)
+    {
+        return (cents < static_cast<signed long>(MINIMUM_BID)) ? MINIMUM_BID
+             : (cents > static_cast<signed long>(MAXIMUM_ASK)) ? MAXIMUM_ASK
+             : static_cast<unsigned long>(cents);
+    }
+
+    unsigned long mCents = 0;
+};
+
+constexpr Price Price::RoundDown(unsigned long tickSize) const
+{
+    if (mCents == 0)
+    {
+        return *this;
+    }
+    const unsigned long rounded = mCents / tickSize * tickSize;
+    return Price(rounded >= MINIMUM_BID ? rounded : (MINIMUM_BID + tickSize - 1) / tickSize * tickSize);
+}
+
+constexpr Price Price::RoundUp(unsigned long tickSize) const
+{
+    if (mCents == 0)
+    {
+        return *this;
+    }
+    const unsigned long rounded = (mCents + tickSize - 1) / tickSize * tickSize;
+    return Price(rounded <= MAXIMUM_ASK ? rounded : MAXIMUM_ASK / tickSize * tickSize);
+}
+
+constexpr Price Price::operator+(PriceDelta delta) const
+{
+    if (mCents == 0)
+    {
+        return *this;
+    }
+    Price result;
+    result.mCents = Clamp(static_cast<signed long>(mCents) + delta.Cents());
+    return result;
+}
+
+// A number of lots. Subtraction stops at zero and addition stops at the
+// largest representable volume, so neither can wrap.
+class Volume
+{
+public:
+    constexpr Volume() = default;
+    constexpr explicit Volume(unsigned long lots) : mLots(lots) {}
+
+    // Negative lot counts become zero.
+    static constexpr Volume FromSigned(signed long lots)
+    {
+        return Volume(lots > 0 ? static_cast<unsigned long>(lots) : 0);
+    }
+
+    constexpr unsigned long Lots() const { return mLots; }
+    constexpr bool IsZero() const { return mLots == 0; }
+
+    constexpr Volume operator+(Volume other) const
+    {
+        return Volume(mLots > std::numeric_limits<unsigned long>::max() - other.mLots
+                      ? std::numeric_limits<unsigned long>::max() : mLots + other.mLots);
+    }
+    constexpr Volume operator-(Volume other) const { return Volume(mLots > other.mLots ? mLots - other.mLots : 0); }
+    constexpr Volume operator*(unsigned long factor) const { return Volume(mLots * factor); }
+    constexpr Volume operator/(unsigned long divisor) const { return Volume(mLots / divisor); }
+
+    constexpr bool operator==(Volume other) const { return mLots == other.mLots; }
+    constexpr bool operator<(Volume other) const { return mLots < other.mLots; }
+
+private:
+    unsigned long mLots = 0;
+};
+
+constexpr Volume Min(Volume a, Volume b) { return (b < a) ? b : a; }
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Price price)
+{
+    strm << price.Cents();
+    return strm;
+}
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Volume volume)
+{
+    strm << volume.Lots();
+    return strm;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
@@ -0,0 +1,58 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "quoteengine.h"
+
+namespace ReadyTraderGo {
+
+int QuoteEngine::Update(unsigned long clientOrderId, const Quote& quote)
+{
+    const OrderRecord* order = mTrader.GetOrderManager().Find(clientOrderId);
+    if (order == nullptr || order->mState != OrderState::LIVE)
+    {
+        return 0;
+    }
+
+    if (quote.mPrice == 0 || quote.mVolume == 0 || quote.mPrice != order->mPrice)
+    {
+        mTrader.SendCancelOrder(clientOrderId);
+        return 1;
+    }
+
+    if (quote.mVolume < order->mRemainingVolume)
+    {
+        // The exchange treats the amended volume as the order's new total,
+        // so the lots already filled have to be added back on.
+        mTrader.SendAmendOrder(clientOrderId, order->mFilledVolume + quote.mVolume);
+        return 1;
+    }
+
+    return 0;
+}
+
+unsigned long QuoteEngine::Insert(Side side, const Quote& quote)
+{
+    if (quote.mPrice == 0 || quote.mVolume == 0 || mTrader.MessageBudget() == 0)
+    {
+        return 0;
+    }
+    const unsigned long id = mTrader.NextClientOrderId();
+    mTrader.SendInsertOrder(id, side, quote.mPrice, quote.mVolume, Lifespan::GOOD_FOR_DAY);
+    return id;
+}
+
+}
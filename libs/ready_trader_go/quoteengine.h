@@ -0,0 +1,61 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTEENGINE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTEENGINE_H
+
+#include "baseautotrader.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+struct Quote
+{
+    unsigned long mPrice = 0;
+    unsigned long mVolume = 0;
+};
+
+// Keeps good-for-day orders in line with desired quotes using as few
+// messages as possible:
+//   * an unchanged quote sends nothing;
+//   * a lower volume at the same price is an amend, keeping queue priority;
+//   * a higher volume at the same price leaves the order alone, again to
+//     keep priority;
+//   * a new price (or a zero quote) cancels the resting order; the
+//     replacement is a separate insert, since an amend cannot change the
+//     price.
+// Orders with a request still in flight are left alone until it completes.
+class QuoteEngine
+{
+public:
+    explicit QuoteEngine(BaseAutoTrader& trader) : mTrader(trader) {}
+
+    // Bring the given resting order into line with the quote and return the
+    // number of messages sent.
+    int Update(unsigned long clientOrderId, const Quote& quote);
+
+    // Insert an order for the quote if the message budget allows, and
+    // return its client order id, or zero if nothing was sent.
+    unsigned long Insert(Side side, const Quote& quote);
+
+private:
+    BaseAutoTrader& mTrader;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTEENGINE_H
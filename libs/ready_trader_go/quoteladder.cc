@@ -0,0 +1,105 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include "quoteladder.h"
+
+namespace ReadyTraderGo {
+
+void QuoteLadder::Prune(Side side)
+{
+    auto& ids = mOrderIds[static_cast<std::size_t>(side)];
+    std::size_t& count = mOrderCounts[static_cast<std::size_t>(side)];
+    const OrderManager& orders = mTrader.GetOrderManager();
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (orders.IsActive(ids[i]))
+        {
+            ids[kept++] = ids[i];
+        }
+    }
+    count = kept;
+}
+
+int QuoteLadder::Update(Side side, const Ladder& ladder)
+{
+    Prune(side);
+
+    auto& ids = mOrderIds[static_cast<std::size_t>(side)];
+    std::size_t& count = mOrderCounts[static_cast<std::size_t>(side)];
+    const OrderManager& orders = mTrader.GetOrderManager();
+    std::array<bool, MAX_LADDER_LEVELS> covered = {};
+    int sent = 0;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const OrderRecord* order = orders.Find(ids[i]);
+        if (order->mState == OrderState::PENDING_CANCEL)
+        {
+            continue;
+        }
+
+        std::size_t level = 0;
+        while (level < ladder.mCount && (covered[level] || ladder.mLevels[level].mPrice != order->mPrice))
+        {
+            ++level;
+        }
+
+        if (level == ladder.mCount)
+        {
+            sent += mEngine.Update(ids[i], Quote{});
+            continue;
+        }
+
+        covered[level] = true;
+        sent += mEngine.Update(ids[i], ladder.mLevels[level]);
+    }
+
+    // Orders still being cancelled count against the limits until the
+    // exchange confirms them, so the budget here is conservative. Levels
+    // left out for want of message budget are picked up by a later update.
+    const ExchangeLimits& limits = mTrader.GetExchangeLimits();
+    for (std::size_t level = 0; level < ladder.mCount && count < MAX_ORDERS_PER_SIDE; ++level)
+    {
+        if (covered[level])
+        {
+            continue;
+        }
+
+        const unsigned long room = mTrader.GetRiskGate().MaxInsertVolume(side);
+        if (orders.ActiveOrderCount() >= limits.mActiveOrderCountLimit || room == 0 || mTrader.MessageBudget() == 0)
+        {
+            break;
+        }
+
+        const Quote& quote = ladder.mLevels[level];
+        const unsigned long id = mEngine.Insert(side, Quote{quote.mPrice, std::min(quote.mVolume, room)});
+        if (id == 0)
+        {
+            break;
+        }
+        ids[count++] = id;
+        ++sent;
+    }
+
+    return sent;
+}
+
+}
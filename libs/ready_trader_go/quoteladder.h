@@ -0,0 +1,85 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
+
+#include <array>
+#include <cstddef>
+
+#include "baseautotrader.h"
+#include "quoteengine.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t MAX_LADDER_LEVELS = 5;
+
+// The quotes wanted on one side of the book, best price first.
+struct Ladder
+{
+    void Add(unsigned long price, unsigned long volume)
+    {
+        if (mCount < MAX_LADDER_LEVELS && price != 0 && volume != 0)
+        {
+            mLevels[mCount++] = Quote{price, volume};
+        }
+    }
+
+    std::array<Quote, MAX_LADDER_LEVELS> mLevels = {};
+    std::size_t mCount = 0;
+};
+
+// Keeps up to MAX_LADDER_LEVELS good-for-day orders per side in line with a
+// ladder of quotes. Each update is matched by price against the orders
+// already resting, and each order is brought into line with its level by a
+// QuoteEngine:
+//   * an order whose price is no longer in the ladder is cancelled;
+//   * an order at a price still in the ladder is amended down if its level
+//     asks for less, and otherwise left alone to keep queue priority;
+//   * a level with no order is inserted, best level first, for as long as
+//     the exchange's limits, the worst-case position and the message
+//     budget allow.
+// Orders awaiting an acknowledgement are left alone but still occupy their
+// price level, and still count against the limits, until they complete.
+class QuoteLadder
+{
+public:
+    explicit QuoteLadder(BaseAutoTrader& trader) : mTrader(trader), mEngine(trader) {}
+
+    // Bring the given side into line with the ladder and return the number
+    // of messages sent.
+    int Update(Side side, const Ladder& ladder);
+
+    // Number of orders this ladder has working on the given side.
+    std::size_t OrderCount(Side side) const { return mOrderCounts[static_cast<std::size_t>(side)]; }
+
+private:
+    // Room for a full ladder plus a full ladder's worth of pending cancels.
+    static constexpr std::size_t MAX_ORDERS_PER_SIDE = 2 * MAX_LADDER_LEVELS;
+
+    void Prune(Side side);
+
+    BaseAutoTrader& mTrader;
+    QuoteEngine mEngine;
+    std::array<std::array<unsigned long, MAX_ORDERS_PER_SIDE>, 2> mOrderIds = {};
+    std::array<std::size_t, 2> mOrderCounts = {};
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
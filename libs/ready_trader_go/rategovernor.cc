@@ -0,0 +1,66 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "rategovernor.h"
+
+namespace ReadyTraderGo {
+
+void MessageRateGovernor::SetLimits(const ExchangeLimits& limits)
+{
+    mWindow = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(limits.mMessageFrequencyInterval)) + SLACK;
+    mLimit = limits.mMessageFrequencyLimit;
+    mReserve = mLimit / 5;
+    mSent.assign(mLimit, Clock::time_point{});
+    mHead = 0;
+    mCount = 0;
+}
+
+void MessageRateGovernor::Expire(Clock::time_point now) noexcept
+{
+    while (mCount != 0 && mSent[mHead] + mWindow <= now)
+    {
+        mHead = (mHead + 1 == mLimit) ? 0 : mHead + 1;
+        --mCount;
+    }
+}
+
+std::size_t MessageRateGovernor::Available(MessageLane lane, Clock::time_point now) noexcept
+{
+    Expire(now);
+    const std::size_t capacity = (lane == MessageLane::URGENT) ? mLimit : mLimit - mReserve;
+    return (capacity > mCount) ? capacity - mCount : 0;
+}
+
+bool MessageRateGovernor::TryAcquire(MessageLane lane, Clock::time_point now) noexcept
+{
+    if (Available(lane, now) == 0)
+    {
+        return false;
+    }
+    std::size_t tail = mHead + mCount;
+    mSent[(tail >= mLimit) ? tail - mLimit : tail] = now;
+    ++mCount;
+    return true;
+}
+
+MessageRateGovernor::Clock::time_point MessageRateGovernor::NextRelease() const noexcept
+{
+    return (mCount != 0) ? mSent[mHead] + mWindow : Clock::time_point{};
+}
+
+}
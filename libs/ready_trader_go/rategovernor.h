@@ -0,0 +1,81 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RATEGOVERNOR_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RATEGOVERNOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "clock.h"
+#include "limits.h"
+
+namespace ReadyTraderGo {
+
+// Messages that keep us safe (cancels, amends and hedges) go in the urgent
+// lane and may use the whole budget. Everything else goes in the normal lane,
+// which leaves a reserve free for the urgent lane.
+enum class MessageLane : unsigned char
+{
+    NORMAL,
+    URGENT
+};
+
+// Client-side copy of the exchange's message frequency limiter: a message
+// may be sent if fewer than the limit have been sent in the trailing
+// interval. The window is held in a ring buffer sized to the limit, so
+// acquiring never allocates.
+class MessageRateGovernor
+{
+public:
+    using Clock = ReadyTraderGo::Clock;
+
+    // Messages are timestamped by the exchange on arrival, so the window is
+    // widened slightly to absorb jitter between our clock and theirs.
+    static constexpr Clock::duration SLACK = std::chrono::milliseconds(2);
+
+    explicit MessageRateGovernor(const ExchangeLimits& limits) { SetLimits(limits); }
+
+    void SetLimits(const ExchangeLimits& limits);
+
+    // The number of messages that could be sent on the given lane right now.
+    std::size_t Available(MessageLane lane, Clock::time_point now) noexcept;
+
+    // Record a message if the lane has budget for it.
+    bool TryAcquire(MessageLane lane, Clock::time_point now) noexcept;
+
+    // The time at which the oldest message in the window drops out of it.
+    Clock::time_point NextRelease() const noexcept;
+
+    std::size_t Limit() const noexcept { return mLimit; }
+    std::size_t Reserve() const noexcept { return mReserve; }
+
+private:
+    void Expire(Clock::time_point now) noexcept;
+
+    Clock::duration mWindow = {};
+    std::size_t mLimit = 0;
+    std::size_t mReserve = 0;
+    std::vector<Clock::time_point> mSent;
+    std::size_t mHead = 0;
+    std::size_t mCount = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RATEGOVERNOR_H
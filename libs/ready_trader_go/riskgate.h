@@ -0,0 +1,188 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKGATE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKGATE_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "limits.h"
+#include "ordermanager.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+enum class RiskVerdict : unsigned char
+{
+    ACCEPT,
+    INVALID_PRICE,
+    INVALID_VOLUME,
+    ACTIVE_ORDER_COUNT,
+    ACTIVE_VOLUME,
+    POSITION,
+    PRICE_BAND,
+    SELF_CROSS,
+    AMEND_INCREASE,
+    ORDER_SLOT_IN_USE,
+    MESSAGE_BACKLOG
+};
+
+inline const char* RiskVerdictMessage(RiskVerdict verdict)
+{
+    switch (verdict)
+    {
+    case RiskVerdict::ACCEPT:
+        return "accepted";
+    case RiskVerdict::INVALID_PRICE:
+        return "order rejected locally: invalid price";
+    case RiskVerdict::INVALID_VOLUME:
+        return "order rejected locally: invalid volume";
+    case RiskVerdict::ACTIVE_ORDER_COUNT:
+        return "order rejected locally: active order count limit";
+    case RiskVerdict::ACTIVE_VOLUME:
+        return "order rejected locally: active order volume limit";
+    case RiskVerdict::POSITION:
+        return "order rejected locally: worst-case position limit";
+    case RiskVerdict::PRICE_BAND:
+        return "order rejected locally: price outside the ETF clamp";
+    case RiskVerdict::SELF_CROSS:
+        return "order rejected locally: in cross with an existing order";
+    case RiskVerdict::AMEND_INCREASE:
+        return "amend rejected locally: amend operation would increase order volume";
+    case RiskVerdict::ORDER_SLOT_IN_USE:
+        return "order rejected locally: order registry slot still in use";
+    case RiskVerdict::MESSAGE_BACKLOG:
+        return "rejected locally: too many messages held back by the message frequency limit";
+    }
+    return "rejected locally";
+}
+
+// Pre-trade checks run before an insert or amend is sent. They mirror the
+// exchange's own checks, using the order manager's view of what is resting,
+// so an order that the exchange would reject (such as one in cross with one
+// of our own, or one that could take the position past the limit if every
+// resting order on its side filled) never leaves the process.
+//
+// The price band comes from the ETF clamp: the exchange marks the ETF
+// position to within EtfClamp of the future price, so buying above (or
+// selling below) that band is a loss as soon as it fills.
+class RiskGate
+{
+public:
+    RiskGate(const ExchangeLimits& limits, const OrderManager& orders) : mLimits(limits), mOrders(orders) {}
+
+    RiskVerdict CheckInsert(Side side, unsigned long price, unsigned long volume) const noexcept;
+    RiskVerdict CheckAmend(unsigned long clientOrderId, unsigned long volume) const noexcept;
+
+    // The largest insert on the given side that would pass the volume and
+    // position checks.
+    unsigned long MaxInsertVolume(Side side) const noexcept;
+
+    // Set the future price that the ETF clamp is measured from. Zero turns
+    // the band check off.
+    void SetReferencePrice(unsigned long futurePrice) noexcept;
+
+private:
+    const ExchangeLimits& mLimits;
+    const OrderManager& mOrders;
+    unsigned long mBandLow = 0;
+    unsigned long mBandHigh = 0;
+};
+
+inline RiskVerdict RiskGate::CheckInsert(Side side, unsigned long price, unsigned long volume) const noexcept
+{
+    if (price < MINIMUM_BID || price > MAXIMUM_ASK || price % mLimits.mTickSize != 0)
+    {
+        return RiskVerdict::INVALID_PRICE;
+    }
+    if (volume == 0)
+    {
+        return RiskVerdict::INVALID_VOLUME;
+    }
+    if (mOrders.ActiveOrderCount() >= mLimits.mActiveOrderCountLimit)
+    {
+        return RiskVerdict::ACTIVE_ORDER_COUNT;
+    }
+    if (mOrders.LiveVolume() + volume > mLimits.mActiveVolumeLimit)
+    {
+        return RiskVerdict::ACTIVE_VOLUME;
+    }
+
+    const long worstCase = static_cast<long>(mOrders.LiveVolume(side) + volume);
+    if (side == Side::BUY ? mOrders.Position() + worstCase > mLimits.mPositionLimit
+                          : mOrders.Position() - worstCase < -mLimits.mPositionLimit)
+    {
+        return RiskVerdict::POSITION;
+    }
+
+    if (mBandHigh != 0 && (side == Side::BUY ? price > mBandHigh : price < mBandLow))
+    {
+        return RiskVerdict::PRICE_BAND;
+    }
+
+    const unsigned long opposite = mOrders.BestPrice(side == Side::BUY ? Side::SELL : Side::BUY);
+    if (opposite != 0 && (side == Side::BUY ? price >= opposite : price <= opposite))
+    {
+        return RiskVerdict::SELF_CROSS;
+    }
+
+    return RiskVerdict::ACCEPT;
+}
+
+inline RiskVerdict RiskGate::CheckAmend(unsigned long clientOrderId, unsigned long volume) const noexcept
+{
+    // An amend can only take volume away, so the only thing to catch is an
+    // attempt to add some. Unknown orders are ignored by the exchange.
+    const OrderRecord* order = mOrders.Find(clientOrderId);
+    if (order != nullptr && volume > order->mVolume)
+    {
+        return RiskVerdict::AMEND_INCREASE;
+    }
+    return RiskVerdict::ACCEPT;
+}
+
+inline unsigned long RiskGate::MaxInsertVolume(Side side) const noexcept
+{
+    const unsigned long liveVolume = mOrders.LiveVolume();
+    const unsigned long volumeRoom = (liveVolume < mLimits.mActiveVolumeLimit) ? mLimits.mActiveVolumeLimit - liveVolume : 0;
+
+    const long exposure = (side == Side::BUY ? mOrders.Position() : -mOrders.Position())
+                          + static_cast<long>(mOrders.LiveVolume(side));
+    const unsigned long positionRoom = (exposure < mLimits.mPositionLimit) ? mLimits.mPositionLimit - exposure : 0;
+
+    return std::min(volumeRoom, positionRoom);
+}
+
+inline void RiskGate::SetReferencePrice(unsigned long futurePrice) noexcept
+{
+    if (futurePrice == 0)
+    {
+        mBandLow = mBandHigh = 0;
+        return;
+    }
+
+    // Same arithmetic as the exchange's account valuation.
+    unsigned long delta = static_cast<unsigned long>(std::round(mLimits.mEtfClamp * static_cast<double>(futurePrice)));
+    delta -= delta % mLimits.mTickSize;
+    mBandLow = futurePrice - delta;
+    mBandHigh = futurePrice + delta;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKGATE_H
@@ -0,0 +1,223 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <utility>
+
+#include <boost/asio/error.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "allocation.h"
+#include "scheduler.h"
+
+namespace ReadyTraderGo {
+
+// An EventId is the event's slot in the pool (plus one, so that zero is
+// never valid) in the low half and the slot's generation in the high half.
+static EventId MakeEventId(std::uint32_t slot, std::uint32_t generation) noexcept
+{
+    return (static_cast<EventId>(generation) << 32) | (static_cast<EventId>(slot) + 1);
+}
+
+EventScheduler::EventScheduler(Clock::time_point start) : mNow(start)
+{
+    sCurrent = this;
+    Clock::SetSimulatedTime(&mNow);
+}
+
+EventScheduler::~EventScheduler()
+{
+    Clock::SetSimulatedTime(nullptr);
+    sCurrent = nullptr;
+}
+
+EventId EventScheduler::Schedule(Clock::time_point time, Handler handler)
+{
+    std::uint32_t slot;
+    if (!mFree.empty())
+    {
+        slot = mFree.back();
+        mFree.pop_back();
+    }
+    else
+    {
+        slot = static_cast<std::uint32_t>(mEvents.size());
+        mEvents.emplace_back();
+    }
+
+    Event& event = mEvents[slot];
+    event.mTime = (time > mNow) ? time : mNow;
+    event.mSequence = mNextSequence++;
+    event.mHandler = std::move(handler);
+
+    mHeap.push_back(slot);
+    event.mHeapIndex = static_cast<std::uint32_t>(mHeap.size() - 1);
+    SiftUp(mHeap.size() - 1);
+    return MakeEventId(slot, event.mGeneration);
+}
+
+bool EventScheduler::Cancel(EventId eventId) noexcept
+{
+    const auto low = static_cast<std::uint32_t>(eventId);
+    if (low == 0 || low > mEvents.size())
+    {
+        return false;
+    }
+    const std::uint32_t slot = low - 1;
+    Event& event = mEvents[slot];
+    if (event.mGeneration != static_cast<std::uint32_t>(eventId >> 32) || event.mHeapIndex == NO_HEAP_INDEX)
+    {
+        return false;
+    }
+
+    Remove(event.mHeapIndex);
+    ++event.mGeneration;
+    event.mHandler = nullptr;
+    mFree.push_back(slot);
+    return true;
+}
+
+bool EventScheduler::RunNext()
+{
+    if (mHeap.empty())
+    {
+        return false;
+    }
+
+    // The slot is freed before the handler runs, so that the handler may
+    // schedule (or try to cancel) events freely.
+    const std::uint32_t slot = mHeap.front();
+    Event& event = mEvents[slot];
+    mNow = event.mTime;
+    Remove(0);
+    ++event.mGeneration;
+    Handler handler = std::move(event.mHandler);
+    event.mHandler = nullptr;
+    mFree.push_back(slot);
+
+    handler();
+    return true;
+}
+
+void EventScheduler::Place(std::size_t heapIndex, std::uint32_t slot) noexcept
+{
+    mHeap[heapIndex] = slot;
+    mEvents[slot].mHeapIndex = static_cast<std::uint32_t>(heapIndex);
+}
+
+void EventScheduler::SiftUp(std::size_t heapIndex) noexcept
+{
+    const std::uint32_t slot = mHeap[heapIndex];
+    while (heapIndex > 0)
+    {
+        const std::size_t parent = (heapIndex - 1) / 2;
+        if (!Earlier(slot, mHeap[parent]))
+        {
+            break;
+        }
+        Place(heapIndex, mHeap[parent]);
+        heapIndex = parent;
+    }
+    Place(heapIndex, slot);
+}
+
+void EventScheduler::SiftDown(std::size_t heapIndex) noexcept
+{
+    const std::uint32_t slot = mHeap[heapIndex];
+    const std::size_t size = mHeap.size();
+    for (;;)
+    {
+        std::size_t child = 2 * heapIndex + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && Earlier(mHeap[child + 1], mHeap[child]))
+        {
+            ++child;
+        }
+        if (!Earlier(mHeap[child], slot))
+        {
+            break;
+        }
+        Place(heapIndex, mHeap[child]);
+        heapIndex = child;
+    }
+    Place(heapIndex, slot);
+}
+
+void EventScheduler::Remove(std::size_t heapIndex) noexcept
+{
+    mEvents[mHeap[heapIndex]].mHeapIndex = NO_HEAP_INDEX;
+    const std::uint32_t last = mHeap.back();
+    mHeap.pop_back();
+    if (heapIndex == mHeap.size())
+    {
+        return;
+    }
+
+    // The last event fills the hole and moves whichever way it needs to.
+    Place(heapIndex, last);
+    if (heapIndex > 0 && Earlier(last, mHeap[(heapIndex - 1) / 2]))
+    {
+        SiftUp(heapIndex);
+    }
+    else
+    {
+        SiftDown(heapIndex);
+    }
+}
+
+void DeadlineTimer::ExpiresAt(Clock::time_point deadline)
+{
+    Cancel();
+
+    mScheduler = EventScheduler::Current();
+    if (mScheduler != nullptr)
+    {
+        mEventId = mScheduler->Schedule(deadline, [this] {
+            mEventId = 0;
+            mHandler();
+        });
+        return;
+    }
+
+    // The asio timer runs on steady_clock, so it is given the delay.
+    mTimer.expires_after(deadline - Clock::now());
+    // Cancelling does not stop a completion that is already queued, so one
+    // from an earlier deadline is recognised by its stale generation.
+    mTimer.async_wait([this, generation = mGeneration](const boost::system::error_code& error) {
+        RTG_ALLOCATION_SCOPE();
+        if (error == boost::asio::error::operation_aborted || generation != mGeneration)
+        {
+            return;
+        }
+        mHandler();
+    });
+}
+
+void DeadlineTimer::Cancel()
+{
+    if (mEventId != 0)
+    {
+        mScheduler->Cancel(mEventId);
+        mEventId = 0;
+    }
+    ++mGeneration;
+    mTimer.cancel();
+}
+
+}
@@ -0,0 +1,144 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+// Identifies a scheduled event. Zero is never a valid id, and an id is not
+// reused after its event runs or is cancelled, so a stale id is harmless.
+using EventId = std::uint64_t;
+
+// A discrete-event scheduler that owns simulated time. Events are kept in a
+// binary heap ordered by time and then by when they were scheduled, so
+// events due at the same time run in the order they were scheduled and a
+// replay runs the same way every time. RunNext moves the Clock to the
+// earliest event and runs it; nothing happens in between, so a replay runs
+// as fast as its events can be handled.
+//
+// While it exists, the scheduler is the Clock's simulated time on the thread
+// that made it and is the thread's Current scheduler, which DeadlineTimers
+// use instead of asio. There may be one per thread. It must outlive
+// everything that schedules events on it.
+//
+// Events live in a pool that only grows, and the heap holds their indexes,
+// so scheduling and cancelling are O(log n) and allocate nothing once the
+// pool is big enough.
+class EventScheduler
+{
+public:
+    using Handler = std::function<void()>;
+
+    explicit EventScheduler(Clock::time_point start);
+    ~EventScheduler();
+
+    EventScheduler(const EventScheduler&) = delete;
+    EventScheduler& operator=(const EventScheduler&) = delete;
+
+    // Run the handler at the given time, or now if that has passed.
+    EventId Schedule(Clock::time_point time, Handler handler);
+
+    // Returns false if the event has already run or been cancelled.
+    bool Cancel(EventId eventId) noexcept;
+
+    // Run the earliest event, if there is one.
+    bool RunNext();
+
+    Clock::time_point Now() const noexcept { return mNow; }
+    std::size_t Pending() const noexcept { return mHeap.size(); }
+
+    // The scheduler on this thread, or null when running in real time.
+    static EventScheduler* Current() noexcept { return sCurrent; }
+
+private:
+    static constexpr std::uint32_t NO_HEAP_INDEX = UINT32_MAX;
+
+    struct Event
+    {
+        Clock::time_point mTime;
+        std::uint64_t mSequence = 0;
+        std::uint32_t mGeneration = 0;
+        std::uint32_t mHeapIndex = NO_HEAP_INDEX;
+        Handler mHandler;
+    };
+
+    bool Earlier(std::uint32_t a, std::uint32_t b) const noexcept
+    {
+        const Event& x = mEvents[a];
+        const Event& y = mEvents[b];
+        return (x.mTime != y.mTime) ? x.mTime < y.mTime : x.mSequence < y.mSequence;
+    }
+
+    void Place(std::size_t heapIndex, std::uint32_t slot) noexcept;
+    void SiftUp(std::size_t heapIndex) noexcept;
+    void SiftDown(std::size_t heapIndex) noexcept;
+    void Remove(std::size_t heapIndex) noexcept;
+
+    Clock::time_point mNow;
+    std::uint64_t mNextSequence = 0;
+    std::vector<Event> mEvents;
+    std::vector<std::uint32_t> mFree;
+    std::vector<std::uint32_t> mHeap;
+
+    static inline thread_local EventScheduler* sCurrent = nullptr;
+};
+
+// A one-shot timer that calls its handler at a Clock time: through asio in
+// real time, or as an event on the thread's EventScheduler when there is
+// one. Setting a new expiry replaces the old one. A replaced or cancelled
+// expiry never calls the handler, even if asio had already queued its
+// completion. The handler is given once, up front, so arming the timer does
+// not allocate.
+class DeadlineTimer
+{
+public:
+    using Handler = std::function<void()>;
+
+    DeadlineTimer(boost::asio::io_context& context, Handler handler)
+        : mTimer(context), mHandler(std::move(handler)) {}
+    ~DeadlineTimer() { Cancel(); }
+
+    DeadlineTimer(const DeadlineTimer&) = delete;
+    DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+
+    void ExpiresAt(Clock::time_point deadline);
+    void ExpiresAfter(Clock::duration delay) { ExpiresAt(Clock::now() + delay); }
+    void Cancel();
+
+private:
+    boost::asio::steady_timer mTimer;
+    Handler mHandler;
+    EventScheduler* mScheduler = nullptr;
+    EventId mEventId = 0;
+    unsigned long mGeneration = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
@@ -0,0 +1,134 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
+
+#include <array>
+#include <cstddef>
+
+#include "clock.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The information channel's sequenced message streams. Each instrument has
+// one of each, numbered independently.
+enum class InformationStream : unsigned char
+{
+    ORDER_BOOK,
+    TRADE_TICKS
+};
+
+enum class SequenceStatus : unsigned char
+{
+    IN_SEQUENCE,                                // The next message, or the first one seen.
+    GAP,                                        // Newer, but some messages in between were missed.
+    DUPLICATE,                                  // Already seen.
+    OUT_OF_ORDER                                // Older than one already seen.
+};
+
+// Tracks the last sequence number and arrival time of each information
+// stream. A message is only passed on if it is newer than anything already
+// seen on its stream, so a strategy never sees an order book go backwards.
+//
+// The exchange numbers trade ticks by their own count per instrument, so
+// a gap there means frames were lost: the shared memory ring only loses
+// them when the publisher laps the reader. Order books are numbered by
+// timer tick, and the exchange's timer skips ticks when it falls behind,
+// so a gap in an order book stream may just be a tick that never was.
+class SequenceTracker
+{
+public:
+    // Check a message and, unless it is a duplicate or out of order, make
+    // it the stream's latest. Missed() then gives the number of messages
+    // skipped in a gap.
+    SequenceStatus Check(Instrument instrument,
+                         InformationStream stream,
+                         unsigned long sequenceNumber,
+                         Clock::time_point now) noexcept;
+
+    unsigned long Missed() const noexcept { return mMissed; }
+
+    // Sequence number and arrival time of the latest message accepted on a
+    // stream, zero and the epoch if there has not been one.
+    unsigned long LastSequenceNumber(Instrument instrument, InformationStream stream) const noexcept
+    {
+        return mStreams[Index(instrument, stream)].mSequenceNumber;
+    }
+    Clock::time_point LastReceived(Instrument instrument, InformationStream stream) const noexcept
+    {
+        return mStreams[Index(instrument, stream)].mReceived;
+    }
+
+    // How long ago the latest message on a stream arrived, or
+    // duration::max() if there has not been one.
+    Clock::duration Age(Instrument instrument, InformationStream stream, Clock::time_point now) const noexcept
+    {
+        const StreamState& state = mStreams[Index(instrument, stream)];
+        return (state.mSequenceNumber != 0) ? now - state.mReceived : Clock::duration::max();
+    }
+
+private:
+    static constexpr std::size_t INSTRUMENT_COUNT = 2;
+    static constexpr std::size_t STREAM_COUNT = 2;
+
+    struct StreamState
+    {
+        unsigned long mSequenceNumber = 0;
+        Clock::time_point mReceived;
+    };
+
+    static std::size_t Index(Instrument instrument, InformationStream stream) noexcept
+    {
+        return static_cast<std::size_t>(instrument) * STREAM_COUNT + static_cast<std::size_t>(stream);
+    }
+
+    std::array<StreamState, INSTRUMENT_COUNT * STREAM_COUNT> mStreams = {};
+    unsigned long mMissed = 0;
+};
+
+inline SequenceStatus SequenceTracker::Check(Instrument instrument,
+                                             InformationStream stream,
+                                             unsigned long sequenceNumber,
+                                             Clock::time_point now) noexcept
+{
+    StreamState& state = mStreams[Index(instrument, stream)];
+    mMissed = 0;
+
+    if (state.mSequenceNumber != 0 && sequenceNumber <= state.mSequenceNumber)
+    {
+        return (sequenceNumber == state.mSequenceNumber) ? SequenceStatus::DUPLICATE
+                                                         : SequenceStatus::OUT_OF_ORDER;
+    }
+
+    // Numbering does not necessarily start at one, so the first message on
+    // a stream is never a gap.
+    const bool gap = state.mSequenceNumber != 0 && sequenceNumber != state.mSequenceNumber + 1;
+    if (gap)
+    {
+        mMissed = sequenceNumber - state.mSequenceNumber - 1;
+    }
+
+    state.mSequenceNumber = sequenceNumber;
+    state.mReceived = now;
+    return gap ? SequenceStatus::GAP : SequenceStatus::IN_SEQUENCE;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
@@ -0,0 +1,270 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <limits>
+
+#include "timerwheel.h"
+
+namespace ReadyTraderGo {
+
+namespace {
+
+constexpr std::uint64_t SLOT_MASK = TimerWheel::WHEEL_SLOTS - 1;
+
+// The occupied slots of a level after the given one.
+inline std::uint64_t SlotsAfter(std::uint64_t occupied, std::uint64_t slot) noexcept
+{
+    return (slot == SLOT_MASK) ? 0 : occupied & (~std::uint64_t(0) << (slot + 1));
+}
+
+}
+
+TimerWheel::TimerWheel(std::size_t capacity, Clock::time_point origin) : mOrigin(origin), mNodes(capacity)
+{
+    for (std::size_t i = capacity; i != 0; --i)
+    {
+        mNodes[i - 1].mNext = mFree;
+        mFree = static_cast<std::uint32_t>(i - 1);
+    }
+    mHeads.fill(NONE);
+}
+
+TimerId TimerWheel::Schedule(Clock::time_point deadline, unsigned long token) noexcept
+{
+    if (mFree == NONE)
+    {
+        return 0;
+    }
+
+    const std::uint32_t index = mFree;
+    Node& node = mNodes[index];
+    mFree = node.mNext;
+
+    // Round up, so that a timer never fires before its deadline.
+    std::uint64_t tick = ToTick(deadline);
+    if (FromTick(tick) < deadline)
+    {
+        ++tick;
+    }
+    node.mDeadline = std::max(tick, mNow + 1);
+    node.mToken = token;
+    Link(index);
+    ++mActive;
+    return (std::uint64_t(node.mGeneration) << 32) | (index + 1);
+}
+
+bool TimerWheel::Cancel(TimerId id) noexcept
+{
+    const std::uint64_t index = (id & 0xffffffff) - 1;
+    if (id == 0 || index >= mNodes.size())
+    {
+        return false;
+    }
+    const Node& node = mNodes[index];
+    if (node.mList == NONE || node.mGeneration != (id >> 32))
+    {
+        return false;
+    }
+    Release(static_cast<std::uint32_t>(index));
+    return true;
+}
+
+TimerWheel::Clock::time_point TimerWheel::NextWakeup() const noexcept
+{
+    return (mActive == 0) ? Clock::time_point::max() : FromTick(NextWakeupTick());
+}
+
+std::uint64_t TimerWheel::NextWakeupTick() const noexcept
+{
+    std::uint64_t earliest = std::numeric_limits<std::uint64_t>::max();
+    for (std::size_t level = 0; level < WHEEL_LEVELS; ++level)
+    {
+        if (mOccupied[level] == 0)
+        {
+            continue;
+        }
+        const std::size_t shift = WHEEL_BITS * level;
+        const std::uint64_t position = mNow >> shift;
+        const std::uint64_t turn = position & ~SLOT_MASK;
+        const std::uint64_t later = SlotsAfter(mOccupied[level], position & SLOT_MASK);
+        const std::uint64_t slot = (later != 0) ? turn + __builtin_ctzll(later)
+                                                : turn + WHEEL_SLOTS + __builtin_ctzll(mOccupied[level]);
+        earliest = std::min(earliest, slot << shift);
+    }
+    return earliest;
+}
+
+void TimerWheel::Link(std::uint32_t index) noexcept
+{
+    const std::uint64_t deadline = mNodes[index].mDeadline;
+    const std::uint64_t delay = (deadline > mNow) ? deadline - mNow : 0;
+    for (std::size_t level = 0; level < WHEEL_LEVELS; ++level)
+    {
+        const std::size_t shift = WHEEL_BITS * level;
+        if (delay < (std::uint64_t(1) << (shift + WHEEL_BITS)))
+        {
+            LinkTo(index, level * WHEEL_SLOTS + ((deadline >> shift) & SLOT_MASK));
+            return;
+        }
+    }
+
+    // Too far out for the top level: park it in the furthest slot, from
+    // which it will be rescheduled.
+    constexpr std::size_t top = WHEEL_LEVELS - 1;
+    const std::uint64_t furthest = ((mNow >> (WHEEL_BITS * top)) + SLOT_MASK) & SLOT_MASK;
+    LinkTo(index, top * WHEEL_SLOTS + furthest);
+}
+
+void TimerWheel::LinkTo(std::uint32_t index, std::size_t list) noexcept
+{
+    Node& node = mNodes[index];
+    node.mList = static_cast<std::uint32_t>(list);
+    node.mPrevious = NONE;
+    node.mNext = mHeads[list];
+    if (node.mNext != NONE)
+    {
+        mNodes[node.mNext].mPrevious = index;
+    }
+    mHeads[list] = index;
+    if (list != EXPIRING)
+    {
+        mOccupied[list / WHEEL_SLOTS] |= std::uint64_t(1) << (list % WHEEL_SLOTS);
+    }
+}
+
+void TimerWheel::Unlink(std::uint32_t index) noexcept
+{
+    Node& node = mNodes[index];
+    if (node.mPrevious != NONE)
+    {
+        mNodes[node.mPrevious].mNext = node.mNext;
+    }
+    else
+    {
+        mHeads[node.mList] = node.mNext;
+    }
+    if (node.mNext != NONE)
+    {
+        mNodes[node.mNext].mPrevious = node.mPrevious;
+    }
+    if (mHeads[node.mList] == NONE && node.mList != EXPIRING)
+    {
+        mOccupied[node.mList / WHEEL_SLOTS] &= ~(std::uint64_t(1) << (node.mList % WHEEL_SLOTS));
+    }
+    node.mList = NONE;
+}
+
+void TimerWheel::Release(std::uint32_t index) noexcept
+{
+    Unlink(index);
+    Node& node = mNodes[index];
+    ++node.mGeneration;
+    node.mNext = mFree;
+    mFree = index;
+    --mActive;
+}
+
+void TimerWheel::Cascade(std::size_t level) noexcept
+{
+    if (level >= WHEEL_LEVELS)
+    {
+        return;
+    }
+
+    // The level above turns over first, so that anything it moves down into
+    // this slot is moved on again below.
+    const std::uint64_t slot = (mNow >> (WHEEL_BITS * level)) & SLOT_MASK;
+    if (slot == 0)
+    {
+        Cascade(level + 1);
+    }
+
+    // Detach the whole list before relinking, since a timer a full turn of
+    // this level away belongs back in the same slot.
+    const std::size_t list = level * WHEEL_SLOTS + slot;
+    std::uint32_t index = mHeads[list];
+    mHeads[list] = NONE;
+    mOccupied[level] &= ~(std::uint64_t(1) << slot);
+    while (index != NONE)
+    {
+        const std::uint32_t next = mNodes[index].mNext;
+        Link(index);
+        index = next;
+    }
+}
+
+// Move time on to the next tick, no later than the target, at which a
+// timer is due, moving its slot to the expiring list. Returns false once
+// the target is reached with nothing more due.
+bool TimerWheel::Step(std::uint64_t target) noexcept
+{
+    while (mNow < target)
+    {
+        if (mActive == 0)
+        {
+            mNow = target;
+            return false;
+        }
+
+        // Jump straight to the next occupied slot of the lowest level, or to
+        // the end of its turn. If the lowest level is empty, jump to the next
+        // turn of a higher level with something to move down, skipping all
+        // the turns in between.
+        const std::uint64_t later = SlotsAfter(mOccupied[0], mNow & SLOT_MASK);
+        std::uint64_t next;
+        if (later != 0)
+        {
+            next = (mNow & ~SLOT_MASK) + __builtin_ctzll(later);
+        }
+        else if (mOccupied[0] != 0)
+        {
+            next = (mNow | SLOT_MASK) + 1;
+        }
+        else
+        {
+            next = NextWakeupTick();
+        }
+        if (next > target)
+        {
+            mNow = target;
+            return false;
+        }
+
+        mNow = next;
+        if ((mNow & SLOT_MASK) == 0)
+        {
+            Cascade(1);
+        }
+
+        const std::size_t list = mNow & SLOT_MASK;
+        if (mHeads[list] != NONE)
+        {
+            for (std::uint32_t index = mHeads[list]; index != NONE; index = mNodes[index].mNext)
+            {
+                mNodes[index].mList = EXPIRING;
+            }
+            mHeads[EXPIRING] = mHeads[list];
+            mHeads[list] = NONE;
+            mOccupied[0] &= ~(std::uint64_t(1) << list);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
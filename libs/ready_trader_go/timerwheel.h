@@ -0,0 +1,159 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TIMERWHEEL_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+// Identifies a scheduled timer. Zero is never a valid id, and an id is not
+// reused after its timer fires or is cancelled, so a stale id is harmless.
+using TimerId = std::uint64_t;
+
+// A hierarchical timing wheel (as in Varghese and Lauck, and the Linux
+// kernel's timer list): WHEEL_LEVELS wheels of WHEEL_SLOTS slots, each
+// slot of one level spanning a whole turn of the level below. A timer goes
+// in the lowest level whose span covers its delay, and is moved down a
+// level when the wheel above turns over to its slot.
+//
+// Scheduling and cancelling are O(1). Timers live in a pool allocated up
+// front, linked into their slots by index, so nothing is allocated after
+// construction. Time only moves when Advance is called, so the wheel is
+// driven by whatever loop owns it; Advance is cheap when nothing is due,
+// and skips empty slots using a bitmap of occupied slots per level.
+//
+// Deadlines are rounded up to RESOLUTION, so timers may fire up to one
+// RESOLUTION late but never early. Delays beyond the span of the top level
+// (about 28 minutes) are parked in its furthest slot and rescheduled from
+// there.
+class TimerWheel
+{
+public:
+    using Clock = ReadyTraderGo::Clock;
+
+    static constexpr Clock::duration RESOLUTION = std::chrono::microseconds(100);
+    static constexpr std::size_t WHEEL_BITS = 6;
+    static constexpr std::size_t WHEEL_SLOTS = std::size_t(1) << WHEEL_BITS;
+    static constexpr std::size_t WHEEL_LEVELS = 4;
+
+    TimerWheel(std::size_t capacity, Clock::time_point origin = Clock::now());
+
+    // Schedule a timer for the given time. Returns zero if every timer in
+    // the pool is in use.
+    TimerId Schedule(Clock::time_point deadline, unsigned long token) noexcept;
+
+    // Returns false if the timer has already fired or been cancelled.
+    bool Cancel(TimerId id) noexcept;
+
+    // Fire every timer due by the given time, in deadline order, by calling
+    // handler(id, token). The handler may schedule and cancel timers.
+    template<typename Handler>
+    std::size_t Advance(Clock::time_point now, Handler&& handler);
+
+    // The earliest time at which Advance could have anything to do: the
+    // next deadline, or the next time a higher level has to be moved down.
+    // Clock::time_point::max() when no timers are scheduled.
+    Clock::time_point NextWakeup() const noexcept;
+
+    std::size_t Active() const noexcept { return mActive; }
+    std::size_t Capacity() const noexcept { return mNodes.size(); }
+
+private:
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+    static constexpr std::size_t LIST_COUNT = WHEEL_LEVELS * WHEEL_SLOTS + 1;
+    static constexpr std::size_t EXPIRING = LIST_COUNT - 1;
+
+    struct Node
+    {
+        std::uint64_t mDeadline = 0;            // In ticks of RESOLUTION since the origin.
+        unsigned long mToken = 0;
+        std::uint32_t mGeneration = 0;
+        std::uint32_t mList = NONE;             // The slot list the node is in, or NONE when free.
+        std::uint32_t mPrevious = NONE;
+        std::uint32_t mNext = NONE;
+    };
+
+    std::uint64_t ToTick(Clock::time_point time) const noexcept;
+    Clock::time_point FromTick(std::uint64_t tick) const noexcept;
+    std::uint64_t NextWakeupTick() const noexcept;
+    void Link(std::uint32_t index) noexcept;
+    void LinkTo(std::uint32_t index, std::size_t list) noexcept;
+    void Unlink(std::uint32_t index) noexcept;
+    void Release(std::uint32_t index) noexcept;
+    void Cascade(std::size_t level) noexcept;
+    bool Step(std::uint64_t target) noexcept;
+
+    Clock::time_point mOrigin;
+    std::uint64_t mNow = 0;                     // The last tick processed.
+    std::size_t mActive = 0;
+    std::vector<Node> mNodes;
+    std::uint32_t mFree = NONE;
+    std::array<std::uint32_t, LIST_COUNT> mHeads;
+    std::array<std::uint64_t, WHEEL_LEVELS> mOccupied = {};
+};
+
+inline std::uint64_t TimerWheel::ToTick(Clock::time_point time) const noexcept
+{
+    return (time <= mOrigin) ? 0 : static_cast<std::uint64_t>((time - mOrigin) / RESOLUTION);
+}
+
+inline TimerWheel::Clock::time_point TimerWheel::FromTick(std::uint64_t tick) const noexcept
+{
+    return mOrigin + tick * RESOLUTION;
+}
+
+template<typename Handler>
+std::size_t TimerWheel::Advance(Clock::time_point now, Handler&& handler)
+{
+    const std::uint64_t target = ToTick(now);
+    if (target <= mNow)
+    {
+        return 0;
+    }
+    if (mActive == 0)
+    {
+        mNow = target;
+        return 0;
+    }
+
+    std::size_t fired = 0;
+    while (Step(target))
+    {
+        while (mHeads[EXPIRING] != NONE)
+        {
+            const std::uint32_t index = mHeads[EXPIRING];
+            const TimerId id = (std::uint64_t(mNodes[index].mGeneration) << 32) | (index + 1);
+            const unsigned long token = mNodes[index].mToken;
+            Release(index);
+            ++fired;
+            handler(id, token);
+        }
+    }
+    return fired;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TIMERWHEEL_H
@@ -0,0 +1,80 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// A competitor's cash, positions and profit, kept the way the exchange's
+// CompetitorAccount keeps them (see account.py). Money is in cents.
+struct CompetitorAccount
+{
+    CompetitorAccount(unsigned long tickSize, double etfClamp) : mTickSize(tickSize), mEtfClamp(etfClamp) {}
+
+    void Transact(Instrument instrument, Side side, unsigned long price, unsigned long volume, long fee)
+    {
+        const long value = static_cast<long>(price * volume);
+        mAccountBalance += (side == Side::SELL) ? value : -value;
+        mAccountBalance -= fee;
+        mTotalFees += fee;
+
+        const long delta = (side == Side::SELL) ? -static_cast<long>(volume) : static_cast<long>(volume);
+        if (instrument == Instrument::FUTURE)
+        {
+            mFuturePosition += delta;
+        }
+        else
+        {
+            mEtfPosition += delta;
+            ((side == Side::SELL) ? mSellVolume : mBuyVolume) += volume;
+        }
+    }
+
+    // Mark to market. The ETF is valued within EtfClamp of the future.
+    void Update(long futurePrice, long etfPrice)
+    {
+        long delta = std::lround(mEtfClamp * static_cast<double>(futurePrice));
+        delta -= delta % static_cast<long>(mTickSize);
+        const long clamped = std::clamp(etfPrice, futurePrice - delta, futurePrice + delta);
+        mProfitOrLoss = mAccountBalance + mFuturePosition * futurePrice + mEtfPosition * clamped;
+        mMaxProfit = std::max(mMaxProfit, mProfitOrLoss);
+        mMaxDrawdown = std::max(mMaxDrawdown, mMaxProfit - mProfitOrLoss);
+    }
+
+    unsigned long mTickSize;
+    double mEtfClamp;
+
+    long mAccountBalance = 0;
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+    unsigned long mBuyVolume = 0;
+    unsigned long mSellVolume = 0;
+    long mTotalFees = 0;
+    long mProfitOrLoss = 0;
+    long mMaxProfit = 0;
+    long mMaxDrawdown = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
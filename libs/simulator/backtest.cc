@@ -0,0 +1,207 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include <ready_trader_go/error.h>
+
+#include "backtest.h"
+
+namespace ReadyTraderGo {
+
+static Clock::time_point ToClockTime(double marketTime)
+{
+    return Clock::time_point(Backtest::ORIGIN + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(marketTime)));
+}
+
+static Clock::duration ToClockDuration(double seconds)
+{
+    if (seconds < 0.0)
+    {
+        throw ReadyTraderGoError("latencies must not be negative");
+    }
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+Backtest::Backtest(const SimulatorConfig& config, MarketEventSource& events)
+    : mConfig(config),
+      mExchange(config, events),
+      mInformationLatency(ToClockDuration(config.mInformationLatency)),
+      mOrderEntryLatency(ToClockDuration(config.mOrderEntryLatency)),
+      mExecutionReportLatency(ToClockDuration(config.mExecutionReportLatency)),
+      mStepClockTime(mScheduler.Now())
+{
+}
+
+// Grid steps keep their exact market time; anything else, such as a
+// message sent from one of the trader's timers, is at the scheduler's time.
+double Backtest::MarketTime() const
+{
+    if (mScheduler.Now() == mStepClockTime)
+    {
+        return mStepTime;
+    }
+    return std::chrono::duration<double>(mScheduler.Now() - Clock::time_point(ORIGIN)).count();
+}
+
+// Step through the union of the two timers' grids, computed from whole
+// numbers of intervals so that they do not drift. The market timer goes
+// first when both are due, as it is started first.
+void Backtest::ScheduleStep()
+{
+    const double marketTime = static_cast<double>(mMarketStep) * mConfig.mMarketEventInterval;
+    const double tickTime = static_cast<double>(mTickStep) * mConfig.mTickInterval;
+    mScheduler.Schedule(ToClockTime(std::min(marketTime, tickTime)), [this] { Step(); });
+}
+
+void Backtest::Step()
+{
+    const double marketTime = static_cast<double>(mMarketStep) * mConfig.mMarketEventInterval;
+    const double tickTime = static_cast<double>(mTickStep) * mConfig.mTickInterval;
+    mStepTime = std::min(marketTime, tickTime);
+    mStepClockTime = mScheduler.Now();
+
+    mExchange.CheckUnhedgedLots(mStepTime);
+    if (marketTime <= mStepTime)
+    {
+        mExchange.ProcessMarketEvents(mStepTime);
+        ++mMarketStep;
+    }
+    if (tickTime <= mStepTime)
+    {
+        mExchange.Tick(mStepTime, ++mTickStep);
+        mDone = mExchange.MarketEventsDone();
+    }
+
+    if (!mDone)
+    {
+        ScheduleStep();
+    }
+}
+
+void Backtest::SendToExchange(unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    if (mOrderEntryLatency == Clock::duration::zero())
+    {
+        mExchange.OnMessage(MarketTime(), messageType, data, size);
+        return;
+    }
+
+    if (size > MAX_SIMULATED_MESSAGE_SIZE)
+    {
+        throw ReadyTraderGoError("message too large for the simulated transport");
+    }
+
+    SimulatedMessage& message = mOrdersInFlight.emplace_back();
+    message.mType = messageType;
+    message.mSize = size;
+    std::copy(data, data + size, message.mData.begin());
+    mScheduler.Schedule(mScheduler.Now() + mOrderEntryLatency, [this] {
+        const SimulatedMessage arrived = mOrdersInFlight.front();
+        mOrdersInFlight.pop_front();
+        mExchange.OnMessage(MarketTime(), arrived.mType, arrived.mData.data(), arrived.mSize);
+    });
+}
+
+void Backtest::Deliver()
+{
+    auto& outbox = mExchange.Outbox();
+    while (!outbox.empty())
+    {
+        const SimulatedMessage message = outbox.front();
+        outbox.pop_front();
+
+        const bool isReport = (message.mChannel == SimulatedChannel::EXECUTION);
+        const Clock::duration latency = isReport ? mExecutionReportLatency : mInformationLatency;
+        if (latency == Clock::duration::zero())
+        {
+            DeliverToTrader(message);
+            continue;
+        }
+
+        // Every message on a channel takes the same time, so they arrive in
+        // the order they were sent.
+        std::deque<SimulatedMessage>& inFlight = isReport ? mReportsInFlight : mInformationInFlight;
+        inFlight.push_back(message);
+        mScheduler.Schedule(mScheduler.Now() + latency, [this, &inFlight] {
+            const SimulatedMessage arrived = inFlight.front();
+            inFlight.pop_front();
+            DeliverToTrader(arrived);
+        });
+    }
+}
+
+void Backtest::DeliverToTrader(const SimulatedMessage& message)
+{
+    if (message.mChannel == SimulatedChannel::EXECUTION)
+    {
+        mConnection->Deliver(message.mType, message.mData.data(), message.mSize);
+    }
+    else
+    {
+        mSubscription->Deliver(message.mType, message.mData.data(), message.mSize);
+    }
+    // Run anything the trader posted, such as local rejects.
+    mContext->poll();
+}
+
+BacktestResult Backtest::Run(BaseAutoTrader& trader, boost::asio::io_context& context)
+{
+    auto connection = std::make_unique<SimulatedConnection>(
+        [this](unsigned char type, unsigned char const* data, std::size_t size) {
+            SendToExchange(type, data, size);
+        });
+    auto info = std::make_shared<SimulatedSubscription>();
+    mConnection = connection.get();
+    mSubscription = info.get();
+    mContext = &context;
+
+    trader.SetExecutionConnection(std::move(connection));
+    trader.SetInformationSubscription(std::move(info));
+    Deliver();
+
+    ScheduleStep();
+    while (!mDone && mExchange.IsConnected() && mScheduler.RunNext())
+    {
+        Deliver();
+    }
+
+    const double endTime = MarketTime();
+    mConnection->Close();
+    mExchange.Disconnect(endTime);
+    mExchange.Outbox().clear();
+    context.poll();
+
+    BacktestResult result;
+    result.mAccount = mExchange.GetAccount();
+    result.mStats = mExchange.GetStats();
+    result.mStatus = mExchange.GetStatus();
+    result.mEndTime = endTime;
+    result.mEventsProcessed = mExchange.EventsProcessed();
+    result.mTicks = mTickStep;
+
+    mConnection = nullptr;
+    mSubscription = nullptr;
+    mContext = nullptr;
+    return result;
+}
+
+}
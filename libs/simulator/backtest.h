@@ -0,0 +1,118 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_BACKTEST_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_BACKTEST_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/clock.h>
+#include <ready_trader_go/scheduler.h>
+
+#include "account.h"
+#include "marketdata.h"
+#include "simulatedexchange.h"
+#include "simulatedtransport.h"
+
+namespace ReadyTraderGo {
+
+struct BacktestResult
+{
+    CompetitorAccount mAccount{0, 0.0};
+    SimulatedExchangeStats mStats;
+    std::string mStatus;
+    double mEndTime = 0.0;                      // Market time at which the session ended.
+    std::size_t mEventsProcessed = 0;
+    unsigned long mTicks = 0;
+};
+
+// Runs an auto-trader over a session of market data in-process, against a
+// SimulatedExchange, with no sockets, shared memory or threads.
+//
+// Time is simulated by an EventScheduler, which is the Clock on this thread
+// for as long as the Backtest exists. The market timer and the tick timer
+// fire on a fixed grid (as the exchange's would at any speed, less their
+// jitter) and the trader's own timers, such as its timer wheel's wakeup and
+// the hedge deadline, fire as events at exactly the times they were set
+// for. Nothing waits on real time, so a session runs as fast as it can be
+// handled and the same way every time. Traders must be constructed after the
+// Backtest, so that their timers start from simulated time too.
+//
+// Messages take the configured one-way latencies in each direction. Each
+// channel is first in, first out, and a message in flight is delivered as an
+// event of its own. Where a latency is zero, a message from the trader is
+// handled as it is sent and the exchange's replies are delivered once the
+// event that caused them has been handled, so the trader is never
+// re-entered. Queue position needs no modelling of its own: the trader's
+// orders rest in the same price-time priority books as the market's, so an
+// order fills only once the market volume ahead of it at its price has
+// traded or gone.
+class Backtest
+{
+public:
+    // The events must outlive the Backtest.
+    Backtest(const SimulatorConfig& config, MarketEventSource& events);
+
+    Backtest(const Backtest&) = delete;
+    Backtest& operator=(const Backtest&) = delete;
+
+    BacktestResult Run(BaseAutoTrader& trader, boost::asio::io_context& context);
+
+    // Where market time zero falls on the Clock.
+    static constexpr Clock::duration ORIGIN = std::chrono::hours(1);
+
+private:
+    void ScheduleStep();
+    void Step();
+    double MarketTime() const;
+
+    void SendToExchange(unsigned char messageType, unsigned char const* data, std::size_t size);
+    void Deliver();
+    void DeliverToTrader(const SimulatedMessage& message);
+
+    SimulatorConfig mConfig;
+    EventScheduler mScheduler{Clock::time_point(ORIGIN)};
+    SimulatedExchange mExchange;
+
+    Clock::duration mInformationLatency;
+    Clock::duration mOrderEntryLatency;
+    Clock::duration mExecutionReportLatency;
+    std::deque<SimulatedMessage> mOrdersInFlight;
+    std::deque<SimulatedMessage> mReportsInFlight;
+    std::deque<SimulatedMessage> mInformationInFlight;
+
+    // The trader's end, during Run.
+    SimulatedConnection* mConnection = nullptr;
+    SimulatedSubscription* mSubscription = nullptr;
+    boost::asio::io_context* mContext = nullptr;
+
+    // The market and tick timers' grid.
+    unsigned long mMarketStep = 0;
+    unsigned long mTickStep = 0;
+    bool mDone = false;
+    double mStepTime = 0.0;                     // Market time of the latest step,
+    Clock::time_point mStepClockTime;           // and where it fell on the Clock.
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_BACKTEST_H
@@ -0,0 +1,365 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/logging.h>
+
+#include "exchangeserver.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_EXS, "EXCHANGE")
+
+namespace ip = boost::asio::ip;
+using boost::asio::ip::tcp;
+
+namespace ReadyTraderGo {
+
+static tcp::endpoint ResolveEndpoint(boost::asio::io_context& context, const std::string& host, unsigned short port)
+{
+    boost::system::error_code error;
+    tcp::resolver resolver(context);
+    auto endpoints = resolver.resolve(host, std::to_string(port), error);
+    if (error || endpoints.empty())
+    {
+        throw ReadyTraderGoError("failed to resolve '" + host + "': " + error.message());
+    }
+    return *endpoints.begin();
+}
+
+static const std::string& InformationFileName(const ExchangeServerConfig& config)
+{
+    if (config.mInfoType != "mmap")
+    {
+        throw ReadyTraderGoError("information type must be 'mmap'");
+    }
+    return config.mInfoName;
+}
+
+ExchangeServer::ExchangeServer(boost::asio::io_context& context,
+                               const SimulatorConfig& config,
+                               const ExchangeServerConfig& serverConfig,
+                               MarketEventSource& events)
+    : mContext(context),
+      mConfig(config),
+      mServerConfig(serverConfig),
+      mExchange(config, events),
+      mPublisher(InformationFileName(serverConfig)),
+      mAcceptor(context),
+      mSocket(context),
+      mTimer(context),
+      mInBuffer(READ_SIZE)
+{
+    if (mServerConfig.mSpeed <= 0.0)
+    {
+        throw ReadyTraderGoError("speed must be greater than zero");
+    }
+
+    const tcp::endpoint endpoint = ResolveEndpoint(context, serverConfig.mExecHost, serverConfig.mExecPort);
+    boost::system::error_code error;
+    mAcceptor.open(endpoint.protocol(), error);
+    if (!error)
+    {
+        mAcceptor.set_option(tcp::acceptor::reuse_address(true), error);
+        mAcceptor.bind(endpoint, error);
+    }
+    if (!error)
+    {
+        mAcceptor.listen(tcp::socket::max_listen_connections, error);
+    }
+    if (error)
+    {
+        throw ReadyTraderGoError("failed to listen on '" + serverConfig.mExecHost + ":"
+                                 + std::to_string(serverConfig.mExecPort) + "': " + error.message());
+    }
+}
+
+void ExchangeServer::Start()
+{
+    RLOG(LG_EXS, LogLevel::LL_INFO) << "listening on " << mServerConfig.mExecHost << ':'
+                                    << mServerConfig.mExecPort << " and publishing to '"
+                                    << mServerConfig.mInfoName << '\'';
+    mAcceptor.async_accept(mSocket, [this](const boost::system::error_code& error) { AcceptHandler(error); });
+}
+
+void ExchangeServer::AcceptHandler(const boost::system::error_code& error)
+{
+    if (error)
+    {
+        if (error != boost::asio::error::operation_aborted)
+        {
+            throw ReadyTraderGoError("accept failed: " + error.message());
+        }
+        return;
+    }
+
+    // The simulated exchange has room for one competitor.
+    mAcceptor.close();
+
+    boost::system::error_code ignored;
+    mSocket.set_option(tcp::no_delay(true), ignored);
+    RLOG(LG_EXS, LogLevel::LL_INFO) << "competitor connected from " << mSocket.remote_endpoint(ignored);
+
+    mOpenTime = SteadyClock::now() + std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(mServerConfig.mMarketOpenDelay));
+    ScheduleStep();
+    AsyncRead();
+}
+
+void ExchangeServer::AsyncRead()
+{
+    mSocket.async_read_some(boost::asio::buffer(mInBuffer.data() + mInSize, mInBuffer.size() - mInSize),
+                            [this](const boost::system::error_code& error, std::size_t size) {
+                                ReadSomeHandler(error, size);
+                            });
+}
+
+void ExchangeServer::ReadSomeHandler(const boost::system::error_code& error, std::size_t size)
+{
+    if (mFinished)
+    {
+        return;
+    }
+
+    if (error)
+    {
+        if (error != boost::asio::error::eof)
+        {
+            RLOG(LG_EXS, LogLevel::LL_ERROR) << "read error: " << error.message();
+        }
+        RLOG(LG_EXS, LogLevel::LL_INFO) << "competitor disconnected at time=" << MarketTime();
+        SetTime(MarketTime());
+        Finish();
+        return;
+    }
+
+    mInSize += size;
+    SetTime(MarketTime());
+    if (mIsOpen)
+    {
+        mExchange.ProcessMarketEvents(mNow);
+    }
+
+    unsigned char const* upto = mInBuffer.data();
+    std::size_t available = mInSize;
+    while (available >= MESSAGE_HEADER_SIZE && mExchange.IsConnected())
+    {
+        uint16_t length;
+        std::memcpy(&length, upto, sizeof(length));
+        const std::size_t messageLength = boost::endian::big_to_native(length);
+        if (messageLength < MESSAGE_HEADER_SIZE)
+        {
+            RLOG(LG_EXS, LogLevel::LL_ERROR) << "malformed message of length " << messageLength;
+            Finish();
+            return;
+        }
+        if (available < messageLength)
+        {
+            break;
+        }
+
+        mExchange.OnMessage(mNow, upto[MESSAGE_TYPE_OFFSET], upto + MESSAGE_HEADER_SIZE,
+                            messageLength - MESSAGE_HEADER_SIZE);
+        upto += messageLength;
+        available -= messageLength;
+    }
+
+    std::memmove(mInBuffer.data(), upto, available);
+    mInSize = available;
+
+    Deliver();
+    if (!mExchange.IsConnected())
+    {
+        Finish();
+        return;
+    }
+    AsyncRead();
+}
+
+void ExchangeServer::AsyncWrite()
+{
+    mIsWriting = true;
+    mWriteBuffer.swap(mOutBuffer);
+    mOutBuffer.clear();
+    boost::asio::async_write(mSocket, boost::asio::buffer(mWriteBuffer),
+                             [this](const boost::system::error_code& error, std::size_t size) {
+                                 WriteHandler(error, size);
+                             });
+}
+
+void ExchangeServer::WriteHandler(const boost::system::error_code& error, std::size_t)
+{
+    mIsWriting = false;
+    if (error)
+    {
+        if (error != boost::asio::error::operation_aborted)
+        {
+            RLOG(LG_EXS, LogLevel::LL_ERROR) << "send failed: " << error.message();
+        }
+        mOutBuffer.clear();
+    }
+
+    if (!mOutBuffer.empty())
+    {
+        AsyncWrite();
+    }
+    else if (mFinished)
+    {
+        CloseSocket();
+    }
+}
+
+void ExchangeServer::ScheduleStep()
+{
+    // Step through the union of the two timers' grids, as a Backtest does.
+    const double marketTime = static_cast<double>(mMarketStep) * mConfig.mMarketEventInterval;
+    const double tickTime = static_cast<double>(mTickStep) * mConfig.mTickInterval;
+    const double next = std::min(marketTime, tickTime);
+    mTimer.expires_at(mOpenTime + std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(next / mServerConfig.mSpeed)));
+    mTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error && !mFinished)
+        {
+            Step();
+        }
+    });
+}
+
+void ExchangeServer::Step()
+{
+    if (!mIsOpen)
+    {
+        RLOG(LG_EXS, LogLevel::LL_INFO) << "market open";
+        mIsOpen = true;
+    }
+
+    const double marketTime = static_cast<double>(mMarketStep) * mConfig.mMarketEventInterval;
+    const double tickTime = static_cast<double>(mTickStep) * mConfig.mTickInterval;
+    SetTime(std::min(marketTime, tickTime));
+
+    bool done = false;
+    mExchange.CheckUnhedgedLots(mNow);
+    if (marketTime <= mNow)
+    {
+        mExchange.ProcessMarketEvents(mNow);
+        ++mMarketStep;
+    }
+    if (tickTime <= mNow)
+    {
+        mExchange.Tick(mNow, ++mTickStep);
+        done = mExchange.MarketEventsDone();
+    }
+    Deliver();
+
+    if (done)
+    {
+        RLOG(LG_EXS, LogLevel::LL_INFO) << "match complete at time=" << mNow;
+        Finish();
+    }
+    else if (!mExchange.IsConnected())
+    {
+        RLOG(LG_EXS, LogLevel::LL_INFO) << "competitor disconnected by the exchange at time=" << mNow;
+        Finish();
+    }
+    else
+    {
+        ScheduleStep();
+    }
+}
+
+void ExchangeServer::Deliver()
+{
+    auto& outbox = mExchange.Outbox();
+    for (const SimulatedMessage& message: outbox)
+    {
+        if (message.mChannel == SimulatedChannel::INFORMATION)
+        {
+            mPublisher.Publish(message.mType, message.mData.data(), message.mSize);
+            continue;
+        }
+
+        const std::size_t messageLength = MESSAGE_HEADER_SIZE + message.mSize;
+        const uint16_t length = boost::endian::native_to_big(static_cast<uint16_t>(messageLength));
+        const std::size_t start = mOutBuffer.size();
+        mOutBuffer.resize(start + messageLength);
+        std::memcpy(mOutBuffer.data() + start, &length, sizeof(length));
+        mOutBuffer[start + MESSAGE_TYPE_OFFSET] = message.mType;
+        std::memcpy(mOutBuffer.data() + start + MESSAGE_HEADER_SIZE, message.mData.data(), message.mSize);
+    }
+    outbox.clear();
+
+    if (!mIsWriting && !mOutBuffer.empty() && mSocket.is_open())
+    {
+        AsyncWrite();
+    }
+}
+
+void ExchangeServer::Finish()
+{
+    if (mFinished)
+    {
+        return;
+    }
+
+    // Anything the exchange sent before closing the connection still goes
+    // out first; the competitor's orders are then cancelled.
+    mFinished = true;
+    mTimer.cancel();
+    Deliver();
+    mExchange.Disconnect(mNow);
+    mExchange.Outbox().clear();
+    if (!mIsWriting)
+    {
+        CloseSocket();
+    }
+}
+
+void ExchangeServer::CloseSocket()
+{
+    boost::system::error_code ignored;
+    mSocket.shutdown(tcp::socket::shutdown_both, ignored);
+    mSocket.close(ignored);
+}
+
+double ExchangeServer::MarketTime() const
+{
+    // Messages that arrive before the open are handled at time zero, as
+    // they are by the Python exchange.
+    const auto now = SteadyClock::now();
+    if (!mIsOpen || now <= mOpenTime)
+    {
+        return 0.0;
+    }
+    return std::chrono::duration<double>(now - mOpenTime).count() * mServerConfig.mSpeed;
+}
+
+void ExchangeServer::SetTime(double now)
+{
+    // A step that fires late is still handled at its grid time, so time
+    // must not be allowed to go backwards for messages handled in between.
+    mNow = std::max(mNow, now);
+}
+
+}
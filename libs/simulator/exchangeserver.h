@@ -0,0 +1,140 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_EXCHANGESERVER_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_EXCHANGESERVER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "framepublisher.h"
+#include "marketdata.h"
+#include "simulatedexchange.h"
+
+namespace ReadyTraderGo {
+
+// Where the exchange listens and publishes and how fast it runs (see
+// exchange.json).
+struct ExchangeServerConfig
+{
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        mExecHost = tree.get<std::string>("Execution.Host");
+        mExecPort = tree.get<unsigned short>("Execution.Port");
+        mInfoType = tree.get<std::string>("Information.Type");
+        mInfoName = tree.get<std::string>("Information.Name");
+        mMarketOpenDelay = tree.get<double>("Engine.MarketOpenDelay", mMarketOpenDelay);
+        mSpeed = tree.get<double>("Engine.Speed", mSpeed);
+    }
+
+    std::string mExecHost;
+    unsigned short mExecPort = 0;
+    std::string mInfoType;
+    std::string mInfoName;
+    double mMarketOpenDelay = 5.0;              // Real seconds from connection to market open.
+    double mSpeed = 1.0;
+};
+
+// A stand-in for the Python exchange that an unmodified auto-trader can
+// connect to: it accepts one execution connection over TCP, publishes order
+// books and trade ticks to a memory-mapped file and replays market data into
+// a SimulatedExchange.
+//
+// The market opens MarketOpenDelay seconds after the competitor connects.
+// From then on the market timer and the tick timer fire on the same fixed
+// grid as in a Backtest, paced against the steady clock at the configured
+// speed but without the Python timers' jitter, so every run publishes the
+// same information at the same offsets from the open. Competitor messages
+// are handled at the market time they arrive, after any market events due
+// by then. The session ends when the market data runs out or the
+// competitor disconnects or is disconnected.
+class ExchangeServer
+{
+public:
+    // The events must outlive the server.
+    ExchangeServer(boost::asio::io_context& context,
+                   const SimulatorConfig& config,
+                   const ExchangeServerConfig& serverConfig,
+                   MarketEventSource& events);
+
+    ExchangeServer(const ExchangeServer&) = delete;
+    ExchangeServer& operator=(const ExchangeServer&) = delete;
+
+    // Start listening; the session runs on the io_context.
+    void Start();
+
+    // True once the session has ended and the last reply has been written.
+    bool IsFinished() const { return mFinished && !mIsWriting; }
+    double Now() const { return mNow; }
+    unsigned long Ticks() const { return mTickStep; }
+    const SimulatedExchange& GetExchange() const { return mExchange; }
+
+private:
+    using SteadyClock = std::chrono::steady_clock;
+
+    // Largest read in one go.
+    static constexpr std::size_t READ_SIZE = 65536;
+
+    void AcceptHandler(const boost::system::error_code& error);
+    void AsyncRead();
+    void ReadSomeHandler(const boost::system::error_code& error, std::size_t size);
+    void AsyncWrite();
+    void WriteHandler(const boost::system::error_code& error, std::size_t size);
+
+    void ScheduleStep();
+    void Step();
+    void Deliver();
+    void Finish();
+    void CloseSocket();
+    double MarketTime() const;
+    void SetTime(double now);
+
+    boost::asio::io_context& mContext;
+    SimulatorConfig mConfig;
+    ExchangeServerConfig mServerConfig;
+    SimulatedExchange mExchange;
+    FramePublisher mPublisher;
+
+    boost::asio::ip::tcp::acceptor mAcceptor;
+    boost::asio::ip::tcp::socket mSocket;
+    boost::asio::steady_timer mTimer;
+    std::vector<unsigned char> mInBuffer;
+    std::size_t mInSize = 0;
+    std::vector<unsigned char> mOutBuffer;      // Waiting to be written.
+    std::vector<unsigned char> mWriteBuffer;    // Being written.
+    bool mIsWriting = false;
+
+    bool mIsOpen = false;
+    bool mFinished = false;
+    SteadyClock::time_point mOpenTime;
+    double mNow = 0.0;
+    unsigned long mMarketStep = 0;
+    unsigned long mTickStep = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_EXCHANGESERVER_H
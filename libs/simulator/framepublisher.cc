@@ -0,0 +1,80 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+
+#include <ready_trader_go/error.h>
+
+#include "framepublisher.h"
+
+namespace interprocess = boost::interprocess;
+
+namespace ReadyTraderGo {
+
+static interprocess::file_mapping CreateZeroedFile(const std::string& filename)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    const std::vector<char> zeros(SUBSCRIPTION_TRANSPORT_BUFFER_SIZE, 0);
+    out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    out.close();
+    if (!out)
+    {
+        throw ReadyTraderGoError("failed to create information file '" + filename + "'");
+    }
+    return interprocess::file_mapping{filename.c_str(), interprocess::read_write};
+}
+
+FramePublisher::FramePublisher(const std::string& filename)
+    : mFile(CreateZeroedFile(filename)),
+      mRegion(mFile, interprocess::read_write, 0, SUBSCRIPTION_TRANSPORT_BUFFER_SIZE),
+      mBuffer(static_cast<unsigned char*>(mRegion.get_address()))
+{
+}
+
+void FramePublisher::Publish(unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    if (size > MAX_FRAME_MESSAGE_SIZE)
+    {
+        throw ReadyTraderGoError("message is too long for an information frame");
+    }
+
+    unsigned char* frame = mBuffer + mPosition;
+    const std::size_t messageLength = MESSAGE_HEADER_SIZE + size;
+    const uint32_t payloadSize = boost::endian::native_to_big(static_cast<uint32_t>(messageLength));
+    const uint16_t length = boost::endian::native_to_big(static_cast<uint16_t>(messageLength));
+    std::memcpy(frame + FRAME_PAYLOAD_SIZE_OFFSET, &payloadSize, sizeof(payloadSize));
+    std::memcpy(frame + FRAME_HEADER_SIZE, &length, sizeof(length));
+    frame[FRAME_HEADER_SIZE + MESSAGE_TYPE_OFFSET] = messageType;
+    std::memcpy(frame + FRAME_HEADER_SIZE + MESSAGE_HEADER_SIZE, data, size);
+
+    // Clear the next frame's flag before setting this one's, so that a
+    // subscriber never runs on into a frame left over from the last lap.
+    mPosition = (mPosition + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
+    volatile unsigned char* const next = mBuffer + mPosition;
+    volatile unsigned char* const flag = frame;
+    *next = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    *flag = 1;
+}
+
+}
@@ -0,0 +1,63 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_FRAMEPUBLISHER_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_FRAMEPUBLISHER_H
+
+#include <cstddef>
+#include <string>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/connectivity.h>
+
+namespace ReadyTraderGo {
+
+// The publishing side of the information channel's memory-mapped
+// transport, laid out as pubsub.py lays it out: a ring of fixed-size frames,
+// each a one-byte flag (set once the frame is written), a big-endian payload
+// length at FRAME_PAYLOAD_SIZE_OFFSET and the payload, which is a whole
+// message including its header.
+//
+// As with the Python publisher, nothing stops a slow subscriber from being
+// lapped; the exchange's pacing is what gives it time to keep up.
+class FramePublisher
+{
+public:
+    // The file is created, or emptied if it already exists.
+    explicit FramePublisher(const std::string& filename);
+
+    FramePublisher(const FramePublisher&) = delete;
+    FramePublisher& operator=(const FramePublisher&) = delete;
+
+    // Publish a message (without its header) of at most
+    // MAX_FRAME_MESSAGE_SIZE bytes.
+    void Publish(unsigned char messageType, unsigned char const* data, std::size_t size);
+
+    static constexpr std::size_t MAX_FRAME_MESSAGE_SIZE = FRAME_SIZE - FRAME_HEADER_SIZE - MESSAGE_HEADER_SIZE;
+
+private:
+    boost::interprocess::file_mapping mFile;
+    boost::interprocess::mapped_region mRegion;
+    unsigned char* mBuffer;
+    std::size_t mPosition = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_FRAMEPUBLISHER_H
@@ -0,0 +1,61 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_FREQUENCYLIMITER_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_FREQUENCYLIMITER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <limits>
+
+namespace ReadyTraderGo {
+
+// The exchange's message frequency limiter (see limiter.py): an event
+// breaches the limit if more than the limit have happened in the trailing
+// interval, this one included. Times must not go backwards.
+class FrequencyLimiter
+{
+public:
+    FrequencyLimiter(double interval, std::size_t limit) : mInterval(interval), mLimit(limit) {}
+
+    bool CheckEvent(double now)
+    {
+        mEvents.push_back(now);
+
+        constexpr double epsilon = std::numeric_limits<double>::epsilon();
+        const double windowStart = now - mInterval;
+        while (mEvents.front() - windowStart <= std::max(mEvents.front(), windowStart) * epsilon)
+        {
+            mEvents.pop_front();
+        }
+
+        return mEvents.size() > mLimit;
+    }
+
+    std::size_t Value() const { return mEvents.size(); }
+    std::size_t Limit() const { return mLimit; }
+
+private:
+    std::deque<double> mEvents;
+    double mInterval;
+    std::size_t mLimit;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_FREQUENCYLIMITER_H
@@ -0,0 +1,208 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <ready_trader_go/error.h>
+
+#include "marketdata.h"
+
+namespace ReadyTraderGo {
+
+// The exchange scales prices in the file (dollars) to cents.
+constexpr double INPUT_SCALING = 100.0;
+
+namespace {
+
+class RowParser
+{
+public:
+    RowParser(const char* begin, const char* end, std::size_t lineNumber)
+        : mUpto(begin), mEnd(end), mLineNumber(lineNumber) {}
+
+    // The next field, which may be empty.
+    std::pair<const char*, const char*> Field()
+    {
+        const char* start = mUpto;
+        while (mUpto != mEnd && *mUpto != ',')
+        {
+            ++mUpto;
+        }
+        const char* finish = mUpto;
+        if (mUpto != mEnd)
+        {
+            ++mUpto;
+        }
+        return {start, finish};
+    }
+
+    double Number(std::pair<const char*, const char*> field) const
+    {
+        if (field.first == field.second)
+        {
+            return 0.0;
+        }
+        char* parsed = nullptr;
+        const double value = std::strtod(field.first, &parsed);
+        if (parsed != field.second)
+        {
+            Fail("bad number");
+        }
+        return value;
+    }
+
+    [[noreturn]] void Fail(const char* what) const
+    {
+        throw ReadyTraderGoError("market data line " + std::to_string(mLineNumber) + ": " + what);
+    }
+
+private:
+    const char* mUpto;
+    const char* mEnd;
+    std::size_t mLineNumber;
+};
+
+bool Equals(std::pair<const char*, const char*> field, const char* text)
+{
+    const std::size_t length = std::strlen(text);
+    return static_cast<std::size_t>(field.second - field.first) == length
+           && std::memcmp(field.first, text, length) == 0;
+}
+
+}
+
+std::vector<MarketEvent> ReadMarketDataCsv(const std::string& filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    if (!file)
+    {
+        throw ReadyTraderGoError("failed to open market data file '" + filename + "'");
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    const std::string text = contents.str();
+
+    std::vector<MarketEvent> events;
+    events.reserve(std::count(text.begin(), text.end(), '\n'));
+
+    const char* upto = text.c_str();
+    const char* const end = upto + text.size();
+    std::size_t lineNumber = 0;
+
+    while (upto < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(upto, '\n', end - upto));
+        if (lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+        const char* const next = lineEnd + 1;
+        if (lineEnd != upto && lineEnd[-1] == '\r')
+        {
+            --lineEnd;
+        }
+
+        // The first line is the header.
+        if (++lineNumber == 1 || lineEnd == upto)
+        {
+            upto = next;
+            continue;
+        }
+
+        RowParser row{upto, lineEnd, lineNumber};
+        MarketEvent event;
+
+        event.mTime = row.Number(row.Field());
+
+        const auto instrument = row.Field();
+        if (Equals(instrument, "0"))
+        {
+            event.mInstrument = Instrument::FUTURE;
+        }
+        else if (Equals(instrument, "1"))
+        {
+            event.mInstrument = Instrument::ETF;
+        }
+        else
+        {
+            row.Fail("bad instrument");
+        }
+
+        const auto operation = row.Field();
+        if (Equals(operation, "Insert"))
+        {
+            event.mOperation = MarketEventOperation::INSERT;
+        }
+        else if (Equals(operation, "Cancel"))
+        {
+            event.mOperation = MarketEventOperation::CANCEL;
+        }
+        else if (Equals(operation, "Amend"))
+        {
+            event.mOperation = MarketEventOperation::AMEND;
+        }
+        else
+        {
+            row.Fail("bad operation");
+        }
+
+        event.mOrderId = static_cast<unsigned long>(row.Number(row.Field()));
+
+        const auto side = row.Field();
+        if (Equals(side, "B"))
+        {
+            event.mSide = Side::BUY;
+        }
+        else if (Equals(side, "A"))
+        {
+            event.mSide = Side::SELL;
+        }
+        else if (side.first != side.second)
+        {
+            row.Fail("bad side");
+        }
+
+        // As the exchange does: int(float(volume)) and int(float(price) * 100).
+        event.mVolume = static_cast<long>(row.Number(row.Field()));
+        event.mPrice = static_cast<unsigned long>(row.Number(row.Field()) * INPUT_SCALING);
+
+        const auto lifespan = row.Field();
+        if (Equals(lifespan, "G"))
+        {
+            event.mLifespan = Lifespan::GOOD_FOR_DAY;
+        }
+        else if (Equals(lifespan, "F"))
+        {
+            event.mLifespan = Lifespan::FILL_AND_KILL;
+        }
+        else if (lifespan.first != lifespan.second)
+        {
+            row.Fail("bad lifespan");
+        }
+
+        events.push_back(event);
+        upto = next;
+    }
+
+    return events;
+}
+
+}
@@ -0,0 +1,90 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATA_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+enum class MarketEventOperation : unsigned char
+{
+    AMEND,
+    CANCEL,
+    INSERT
+};
+
+// One row of a market data file: an order placed, reduced or withdrawn by
+// the rest of the market. An amend's volume is the (negative) change in the
+// order's volume. Prices are in cents.
+struct MarketEvent
+{
+    double mTime = 0.0;                         // Seconds since the market opened.
+    unsigned long mOrderId = 0;
+    long mVolume = 0;
+    unsigned long mPrice = 0;
+    Instrument mInstrument = Instrument::FUTURE;
+    MarketEventOperation mOperation = MarketEventOperation::INSERT;
+    Side mSide = Side::SELL;
+    Lifespan mLifespan = Lifespan::GOOD_FOR_DAY;
+};
+
+// A forward-only sequence of market events in time order.
+class MarketEventSource
+{
+public:
+    virtual ~MarketEventSource() = default;
+
+    // Fill in the next event and return true, or return false at the end.
+    virtual bool Next(MarketEvent& event) = 0;
+};
+
+// Events held in memory. The vector must outlive the source.
+class MarketEventVectorSource : public MarketEventSource
+{
+public:
+    explicit MarketEventVectorSource(const std::vector<MarketEvent>& events) : mEvents(events) {}
+
+    bool Next(MarketEvent& event) override
+    {
+        if (mNext == mEvents.size())
+        {
+            return false;
+        }
+        event = mEvents[mNext++];
+        return true;
+    }
+
+private:
+    const std::vector<MarketEvent>& mEvents;
+    std::size_t mNext = 0;
+};
+
+// Reads a market data CSV file (Time,Instrument,Operation,OrderId,Side,
+// Volume,Price,Lifespan) the same way the exchange's MarketEventsReader
+// does, including its truncation of volumes and scaled prices. Throws a
+// ReadyTraderGoError if the file cannot be read or a row cannot be parsed.
+std::vector<MarketEvent> ReadMarketDataCsv(const std::string& filename);
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATA_H
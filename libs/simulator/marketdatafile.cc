@@ -0,0 +1,233 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <boost/interprocess/exceptions.hpp>
+
+#include <ready_trader_go/error.h>
+
+#include "marketdatafile.h"
+
+namespace ReadyTraderGo {
+
+namespace {
+
+constexpr std::size_t Align(std::size_t offset)
+{
+    return (offset + 7) & ~static_cast<std::size_t>(7);
+}
+
+// Where each column starts, in bytes from the start of the file.
+struct Layout
+{
+    Layout(std::size_t eventCount, const std::array<std::uint64_t, 2>& instrumentEventCounts)
+    {
+        mTimeDeltas = Align(sizeof(MarketDataFileHeader));
+        mOrderIds = Align(mTimeDeltas + eventCount * sizeof(std::uint32_t));
+        mVolumes = Align(mOrderIds + eventCount * sizeof(std::uint32_t));
+        mPriceDeltas = Align(mVolumes + eventCount * sizeof(std::int32_t));
+        mInstruments = Align(mPriceDeltas + eventCount * sizeof(std::int32_t));
+        mOperations = Align(mInstruments + eventCount);
+        mSides = Align(mOperations + eventCount);
+        mLifespans = Align(mSides + eventCount);
+        mIndexes[0] = Align(mLifespans + eventCount);
+        mIndexes[1] = Align(mIndexes[0] + instrumentEventCounts[0] * sizeof(std::uint32_t));
+        mSize = Align(mIndexes[1] + instrumentEventCounts[1] * sizeof(std::uint32_t));
+    }
+
+    std::size_t mTimeDeltas;
+    std::size_t mOrderIds;
+    std::size_t mVolumes;
+    std::size_t mPriceDeltas;
+    std::size_t mInstruments;
+    std::size_t mOperations;
+    std::size_t mSides;
+    std::size_t mLifespans;
+    std::array<std::size_t, 2> mIndexes;
+    std::size_t mSize;
+};
+
+template<typename T, typename U>
+T Narrow(U value, std::size_t eventNumber, const char* what)
+{
+    if (value < static_cast<U>(std::numeric_limits<T>::min()) || value > static_cast<U>(std::numeric_limits<T>::max()))
+    {
+        throw ReadyTraderGoError("market event " + std::to_string(eventNumber) + ": " + what + " does not fit");
+    }
+    return static_cast<T>(value);
+}
+
+}
+
+void WriteMarketDataFile(const std::string& filename, const std::vector<MarketEvent>& events)
+{
+    MarketDataFileHeader header;
+    header.mEventCount = events.size();
+    for (const MarketEvent& event: events)
+    {
+        ++header.mInstrumentEventCounts[static_cast<std::size_t>(event.mInstrument)];
+    }
+    if (events.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw ReadyTraderGoError("too many market events for one file");
+    }
+
+    const Layout layout{events.size(), header.mInstrumentEventCounts};
+    std::vector<std::uint64_t> storage(layout.mSize / sizeof(std::uint64_t));
+    auto* const base = reinterpret_cast<unsigned char*>(storage.data());
+    std::memcpy(base, &header, sizeof(header));
+
+    auto* const timeDeltas = reinterpret_cast<std::uint32_t*>(base + layout.mTimeDeltas);
+    auto* const orderIds = reinterpret_cast<std::uint32_t*>(base + layout.mOrderIds);
+    auto* const volumes = reinterpret_cast<std::int32_t*>(base + layout.mVolumes);
+    auto* const priceDeltas = reinterpret_cast<std::int32_t*>(base + layout.mPriceDeltas);
+    auto* const instruments = base + layout.mInstruments;
+    auto* const operations = base + layout.mOperations;
+    auto* const sides = base + layout.mSides;
+    auto* const lifespans = base + layout.mLifespans;
+    std::array<std::uint32_t*, 2> indexes = {reinterpret_cast<std::uint32_t*>(base + layout.mIndexes[0]),
+                                             reinterpret_cast<std::uint32_t*>(base + layout.mIndexes[1])};
+
+    std::array<std::int64_t, 2> lastTimes = {};
+    std::array<std::int64_t, 2> lastPrices = {};
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        const MarketEvent& event = events[i];
+        const auto instrument = static_cast<std::size_t>(event.mInstrument);
+
+        // Times are kept exactly, so a replay of the file sees the very same
+        // doubles as a replay of the CSV.
+        const std::int64_t time = std::llround(event.mTime * MarketDataFileHeader::TIME_UNITS_PER_SECOND);
+        if (static_cast<double>(time) / MarketDataFileHeader::TIME_UNITS_PER_SECOND != event.mTime)
+        {
+            throw ReadyTraderGoError("market event " + std::to_string(i) + ": time is not a whole number of microseconds");
+        }
+        timeDeltas[i] = Narrow<std::uint32_t>(time - lastTimes[instrument], i, "time delta");
+        lastTimes[instrument] = time;
+
+        const auto price = static_cast<std::int64_t>(event.mPrice);
+        priceDeltas[i] = Narrow<std::int32_t>(price - lastPrices[instrument], i, "price delta");
+        lastPrices[instrument] = price;
+
+        orderIds[i] = Narrow<std::uint32_t>(event.mOrderId, i, "order id");
+        volumes[i] = Narrow<std::int32_t>(event.mVolume, i, "volume");
+        instruments[i] = static_cast<std::uint8_t>(event.mInstrument);
+        operations[i] = static_cast<std::uint8_t>(event.mOperation);
+        sides[i] = static_cast<std::uint8_t>(event.mSide);
+        lifespans[i] = static_cast<std::uint8_t>(event.mLifespan);
+        *indexes[instrument]++ = static_cast<std::uint32_t>(i);
+    }
+
+    std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(base), static_cast<std::streamsize>(layout.mSize));
+    file.close();
+    if (!file)
+    {
+        throw ReadyTraderGoError("failed to write market data file '" + filename + "'");
+    }
+}
+
+MarketDataFile::MarketDataFile(const std::string& filename)
+{
+    try
+    {
+        mFile = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+        mRegion = boost::interprocess::mapped_region(mFile, boost::interprocess::read_only);
+    }
+    catch (const boost::interprocess::interprocess_exception& e)
+    {
+        throw ReadyTraderGoError("failed to map market data file '" + filename + "': " + e.what());
+    }
+
+    const auto* const base = static_cast<const unsigned char*>(mRegion.get_address());
+    const auto fail = [&filename](const char* what) {
+        throw ReadyTraderGoError("market data file '" + filename + "' " + what);
+    };
+
+    if (mRegion.get_size() < sizeof(MarketDataFileHeader))
+    {
+        fail("is too short");
+    }
+    mHeader = reinterpret_cast<const MarketDataFileHeader*>(base);
+    if (mHeader->mMagic != MarketDataFileHeader::MAGIC)
+    {
+        fail("is not a market data file");
+    }
+    if (mHeader->mByteOrderMark != MarketDataFileHeader::BYTE_ORDER_MARK)
+    {
+        fail("was written on a machine with the other byte order");
+    }
+    if (mHeader->mVersion != MarketDataFileHeader::VERSION)
+    {
+        fail("has an unsupported version");
+    }
+    if (mHeader->mInstrumentEventCounts[0] + mHeader->mInstrumentEventCounts[1] != mHeader->mEventCount)
+    {
+        fail("has inconsistent event counts");
+    }
+
+    const Layout layout{mHeader->mEventCount, mHeader->mInstrumentEventCounts};
+    if (mRegion.get_size() != layout.mSize)
+    {
+        fail("has the wrong size");
+    }
+
+    mTimeDeltas = reinterpret_cast<const std::uint32_t*>(base + layout.mTimeDeltas);
+    mOrderIds = reinterpret_cast<const std::uint32_t*>(base + layout.mOrderIds);
+    mVolumes = reinterpret_cast<const std::int32_t*>(base + layout.mVolumes);
+    mPriceDeltas = reinterpret_cast<const std::int32_t*>(base + layout.mPriceDeltas);
+    mInstruments = base + layout.mInstruments;
+    mOperations = base + layout.mOperations;
+    mSides = base + layout.mSides;
+    mLifespans = base + layout.mLifespans;
+    mIndexes[0] = reinterpret_cast<const std::uint32_t*>(base + layout.mIndexes[0]);
+    mIndexes[1] = reinterpret_cast<const std::uint32_t*>(base + layout.mIndexes[1]);
+}
+
+bool MarketDataFile::Cursor::Next(MarketEvent& event)
+{
+    if (mNext == mCount)
+    {
+        return false;
+    }
+
+    const MarketDataFile& file = *mFile;
+    const std::size_t i = (mIndex != nullptr) ? mIndex[mNext] : mNext;
+    ++mNext;
+
+    // Anything other than the future is the ETF, so that a corrupt file
+    // cannot take the deltas out of bounds.
+    const std::size_t instrument = (file.mInstruments[i] == 0) ? 0 : 1;
+    mTimes[instrument] += file.mTimeDeltas[i];
+    mPrices[instrument] += file.mPriceDeltas[i];
+
+    event.mTime = static_cast<double>(mTimes[instrument]) / file.mHeader->mTimeUnitsPerSecond;
+    event.mOrderId = file.mOrderIds[i];
+    event.mVolume = file.mVolumes[i];
+    event.mPrice = static_cast<unsigned long>(mPrices[instrument]);
+    event.mInstrument = static_cast<Instrument>(instrument);
+    event.mOperation = static_cast<MarketEventOperation>(file.mOperations[i]);
+    event.mSide = static_cast<Side>(file.mSides[i]);
+    event.mLifespan = static_cast<Lifespan>(file.mLifespans[i]);
+    return true;
+}
+
+}
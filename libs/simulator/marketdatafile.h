@@ -0,0 +1,138 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATAFILE_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATAFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "marketdata.h"
+
+namespace ReadyTraderGo {
+
+// A columnar binary copy of a market data file, made to be memory mapped.
+// After a fixed header come fixed-width columns, one value per event:
+//
+//     time delta     uint32   microseconds since the instrument's last event
+//     order id       uint32
+//     volume         int32
+//     price delta    int32    cents since the instrument's last event
+//     instrument     uint8
+//     operation      uint8
+//     side           uint8
+//     lifespan       uint8
+//
+// and then, for each instrument, the index of each of its events. Deltas run
+// per instrument so that either instrument's events can be walked through
+// its index alone. Every column starts on an eight-byte boundary and values
+// are in the byte order of the machine that wrote the file (which the
+// header records).
+struct MarketDataFileHeader
+{
+    static constexpr std::array<char, 8> MAGIC = {'R', 'T', 'G', 'M', 'D', 'A', 'T', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr std::uint32_t TIME_UNITS_PER_SECOND = 1000000;
+
+    std::array<char, 8> mMagic = MAGIC;
+    std::uint32_t mVersion = VERSION;
+    std::uint32_t mByteOrderMark = BYTE_ORDER_MARK;
+    std::uint32_t mTimeUnitsPerSecond = TIME_UNITS_PER_SECOND;
+    std::uint32_t mReserved = 0;
+    std::uint64_t mEventCount = 0;
+    std::array<std::uint64_t, 2> mInstrumentEventCounts = {};
+};
+
+// Write events (as read by ReadMarketDataCsv) to a market data file. Throws
+// a ReadyTraderGoError if the events cannot be represented (times that are
+// not whole microseconds or go backwards, or values too wide for their
+// column) or the file cannot be written.
+void WriteMarketDataFile(const std::string& filename, const std::vector<MarketEvent>& events);
+
+// A read-only mapping of a market data file. Nothing is copied or decoded
+// until it is iterated, and any number of cursors, on any threads, may
+// share one file.
+class MarketDataFile
+{
+public:
+    // Throws a ReadyTraderGoError if the file cannot be mapped or is not a
+    // market data file this build can read.
+    explicit MarketDataFile(const std::string& filename);
+
+    // Decodes events straight from the mapping. A cursor must not outlive
+    // its file.
+    class Cursor : public MarketEventSource
+    {
+    public:
+        bool Next(MarketEvent& event) override;
+
+    private:
+        friend class MarketDataFile;
+
+        Cursor(const MarketDataFile& file, const std::uint32_t* index, std::size_t count)
+            : mFile(&file), mIndex(index), mCount(count) {}
+
+        const MarketDataFile* mFile;
+        const std::uint32_t* mIndex;            // Null to walk every event.
+        std::size_t mCount;
+        std::size_t mNext = 0;
+        std::array<std::uint64_t, 2> mTimes = {};
+        std::array<std::int64_t, 2> mPrices = {};
+    };
+
+    // Every event in file order, or the events for one instrument.
+    Cursor Events() const { return Cursor(*this, nullptr, Size()); }
+    Cursor Events(Instrument instrument) const
+    {
+        const auto i = static_cast<std::size_t>(instrument);
+        return Cursor(*this, mIndexes[i], mHeader->mInstrumentEventCounts[i]);
+    }
+
+    std::size_t Size() const { return mHeader->mEventCount; }
+    std::size_t Size(Instrument instrument) const
+    {
+        return mHeader->mInstrumentEventCounts[static_cast<std::size_t>(instrument)];
+    }
+
+private:
+    boost::interprocess::file_mapping mFile;
+    boost::interprocess::mapped_region mRegion;
+
+    const MarketDataFileHeader* mHeader = nullptr;
+    const std::uint32_t* mTimeDeltas = nullptr;
+    const std::uint32_t* mOrderIds = nullptr;
+    const std::int32_t* mVolumes = nullptr;
+    const std::int32_t* mPriceDeltas = nullptr;
+    const std::uint8_t* mInstruments = nullptr;
+    const std::uint8_t* mOperations = nullptr;
+    const std::uint8_t* mSides = nullptr;
+    const std::uint8_t* mLifespans = nullptr;
+    std::array<const std::uint32_t*, 2> mIndexes = {};
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_MARKETDATAFILE_H
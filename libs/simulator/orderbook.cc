@@ -0,0 +1,644 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include <ready_trader_go/error.h>
+
+#include "orderbook.h"
+
+namespace ReadyTraderGo {
+
+// Python's round(), which the exchange uses for fees: to nearest, ties to
+// even.
+static long RoundFee(unsigned long price, unsigned long volume, double fee)
+{
+    return static_cast<long>(std::nearbyint(static_cast<double>(price * volume) * fee));
+}
+
+OrderBook::Level& OrderBook::BookSide::Get(long tick)
+{
+    if (Level* level = Find(tick))
+    {
+        return *level;
+    }
+
+    // A window with nothing in it is free to move to wherever the market is
+    // now.
+    const long size = static_cast<long>(mLevels.size());
+    if (mWindowLevelCount == 0 && size != 0)
+    {
+        mBaseTick = tick - size / 2;
+    }
+    else
+    {
+        constexpr long INITIAL_TICKS = 1024;
+        const long low = (size == 0) ? tick : std::min(tick, mBaseTick);
+        const long high = (size == 0) ? tick : std::max(tick, mBaseTick + size - 1);
+        const long span = high - low + 1;
+        if (span > static_cast<long>(MAX_GRID_TICKS))
+        {
+            return mOverflow[tick];
+        }
+
+        // Leave room on both sides so that a drifting market grows the array
+        // only now and then.
+        const long newSize = std::min(std::max({INITIAL_TICKS, 2 * size, 2 * span}),
+                                      static_cast<long>(MAX_GRID_TICKS));
+        const long newBase = low - (newSize - span) / 2;
+
+        std::vector<Level> levels(newSize);
+        if (size != 0)
+        {
+            std::copy(mLevels.begin(), mLevels.end(), levels.begin() + (mBaseTick - newBase));
+        }
+        mLevels = std::move(levels);
+        mBaseTick = newBase;
+    }
+
+    // Bring in any overflow levels that the window now covers.
+    const long end = mBaseTick + static_cast<long>(mLevels.size());
+    for (auto it = mOverflow.lower_bound(mBaseTick); it != mOverflow.end() && it->first < end;)
+    {
+        mLevels[it->first - mBaseTick] = it->second;
+        ++mWindowLevelCount;
+        it = mOverflow.erase(it);
+    }
+    return mLevels[tick - mBaseTick];
+}
+
+void OrderBook::BookSide::Added(long tick)
+{
+    if (InWindow(tick))
+    {
+        ++mWindowLevelCount;
+    }
+    if (mLevelCount++ == 0 || Better(tick, mBestTick))
+    {
+        mBestTick = tick;
+    }
+}
+
+void OrderBook::BookSide::Emptied(long tick)
+{
+    if (InWindow(tick))
+    {
+        --mWindowLevelCount;
+    }
+    else
+    {
+        mOverflow.erase(tick);
+    }
+
+    // Every other level lies beyond the old best.
+    if (--mLevelCount != 0 && tick == mBestTick)
+    {
+        mBestTick = Seek(tick + Step());
+    }
+}
+
+long OrderBook::BookSide::Seek(long from) const
+{
+    // The nearest overflow level, which bounds the search of the window.
+    bool haveOverflow = false;
+    long overflowTick = 0;
+    if (!mOverflow.empty())
+    {
+        if (mAscending)
+        {
+            auto it = mOverflow.lower_bound(from);
+            if (it != mOverflow.end())
+            {
+                haveOverflow = true;
+                overflowTick = it->first;
+            }
+        }
+        else
+        {
+            auto it = mOverflow.upper_bound(from);
+            if (it != mOverflow.begin())
+            {
+                haveOverflow = true;
+                overflowTick = std::prev(it)->first;
+            }
+        }
+    }
+
+    if (mWindowLevelCount != 0)
+    {
+        const long size = static_cast<long>(mLevels.size());
+        if (mAscending)
+        {
+            const long end = haveOverflow ? std::min(size, overflowTick - mBaseTick) : size;
+            for (long i = std::max(from - mBaseTick, 0L); i < end; ++i)
+            {
+                if (mLevels[i].mTotalVolume != 0)
+                {
+                    return mBaseTick + i;
+                }
+            }
+        }
+        else
+        {
+            const long end = haveOverflow ? std::max(-1L, overflowTick - mBaseTick) : -1;
+            for (long i = std::min(from - mBaseTick, size - 1); i > end; --i)
+            {
+                if (mLevels[i].mTotalVolume != 0)
+                {
+                    return mBaseTick + i;
+                }
+            }
+        }
+    }
+    return overflowTick;
+}
+
+OrderBook::OrderIndex::OrderIndex() : mEntries(1024), mMask(mEntries.size() - 1)
+{
+}
+
+std::size_t OrderBook::OrderIndex::Home(const IOrderListener* listener, unsigned long clientOrderId) const
+{
+    std::uint64_t hash = clientOrderId * 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<std::uintptr_t>(listener);
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return static_cast<std::size_t>(hash) & mMask;
+}
+
+OrderBook::Slot OrderBook::OrderIndex::Find(const IOrderListener* listener, unsigned long clientOrderId) const
+{
+    for (std::size_t i = Home(listener, clientOrderId);; i = (i + 1) & mMask)
+    {
+        const Entry& entry = mEntries[i];
+        if (entry.mSlot == NO_SLOT || (entry.mClientOrderId == clientOrderId && entry.mListener == listener))
+        {
+            return entry.mSlot;
+        }
+    }
+}
+
+void OrderBook::OrderIndex::Insert(const IOrderListener* listener, unsigned long clientOrderId, Slot slot)
+{
+    // Kept at most half full.
+    if (2 * (mSize + 1) > mEntries.size())
+    {
+        Grow();
+    }
+
+    std::size_t i = Home(listener, clientOrderId);
+    while (mEntries[i].mSlot != NO_SLOT)
+    {
+        i = (i + 1) & mMask;
+    }
+    mEntries[i] = Entry{clientOrderId, listener, slot};
+    ++mSize;
+}
+
+void OrderBook::OrderIndex::Erase(const IOrderListener* listener, unsigned long clientOrderId)
+{
+    std::size_t i = Home(listener, clientOrderId);
+    while (mEntries[i].mClientOrderId != clientOrderId || mEntries[i].mListener != listener)
+    {
+        i = (i + 1) & mMask;
+    }
+    --mSize;
+
+    // Close the gap by moving back any later entry of the run that may not
+    // live beyond it, so that lookups never need tombstones.
+    for (std::size_t j = (i + 1) & mMask; mEntries[j].mSlot != NO_SLOT; j = (j + 1) & mMask)
+    {
+        const std::size_t home = Home(mEntries[j].mListener, mEntries[j].mClientOrderId);
+        if (((j - home) & mMask) >= ((j - i) & mMask))
+        {
+            mEntries[i] = mEntries[j];
+            i = j;
+        }
+    }
+    mEntries[i] = Entry{};
+}
+
+void OrderBook::OrderIndex::Grow()
+{
+    std::vector<Entry> entries(2 * mEntries.size());
+    std::swap(entries, mEntries);
+    mMask = mEntries.size() - 1;
+    mSize = 0;
+    for (const Entry& entry: entries)
+    {
+        if (entry.mSlot != NO_SLOT)
+        {
+            Insert(entry.mListener, entry.mClientOrderId, entry.mSlot);
+        }
+    }
+}
+
+OrderBook::OrderBook(Instrument instrument, unsigned long tickSize, double makerFee, double takerFee)
+    : mInstrument(instrument), mTickSize(tickSize), mMakerFee(makerFee), mTakerFee(takerFee)
+{
+    mAskTicks.reserve(64);
+    mBidTicks.reserve(64);
+}
+
+OrderBook::Slot OrderBook::Allocate()
+{
+    if (mFreeSlots != NO_SLOT)
+    {
+        const Slot slot = mFreeSlots;
+        mFreeSlots = At(slot).mNext;
+        return slot;
+    }
+    if ((mNextSlot >> CHUNK_SHIFT) == mChunks.size())
+    {
+        mChunks.push_back(std::make_unique<Order[]>(CHUNK_MASK + 1));
+    }
+    return mNextSlot++;
+}
+
+void OrderBook::Free(Slot slot)
+{
+    Order& order = At(slot);
+    if (order.mIsResting)
+    {
+        mIndex.Erase(order.mListener, order.mClientOrderId);
+    }
+    order = Order{};
+    order.mNext = mFreeSlots;
+    mFreeSlots = slot;
+}
+
+bool OrderBook::Insert(double now,
+                       IOrderListener* listener,
+                       unsigned long clientOrderId,
+                       Side side,
+                       unsigned long price,
+                       unsigned long volume,
+                       Lifespan lifespan)
+{
+    if (mIndex.Find(listener, clientOrderId) != NO_SLOT)
+    {
+        return false;
+    }
+
+    const Slot slot = Allocate();
+    Order& order = At(slot);
+    order.mClientOrderId = clientOrderId;
+    order.mPrice = price;
+    order.mVolume = volume;
+    order.mRemainingVolume = volume;
+    order.mListener = listener;
+    order.mInstrument = mInstrument;
+    order.mLifespan = lifespan;
+    order.mSide = side;
+
+    if (side == Side::SELL && !mBids.Empty() && price <= TickPrice(mBids.mBestTick))
+    {
+        Trade(now, slot, mBids);
+    }
+    else if (side == Side::BUY && !mAsks.Empty() && price >= TickPrice(mAsks.mBestTick))
+    {
+        Trade(now, slot, mAsks);
+    }
+
+    if (order.mRemainingVolume > 0 && lifespan == Lifespan::GOOD_FOR_DAY)
+    {
+        Place(now, slot);
+        return true;
+    }
+
+    if (order.mRemainingVolume > 0)
+    {
+        const unsigned long remaining = order.mRemainingVolume;
+        order.mRemainingVolume = 0;
+        if (listener)
+        {
+            listener->OnOrderCancelled(now, order, remaining);
+        }
+    }
+    Free(slot);
+    return true;
+}
+
+bool OrderBook::Amend(double now, const IOrderListener* listener, unsigned long clientOrderId, long newVolume)
+{
+    const Slot slot = mIndex.Find(listener, clientOrderId);
+    if (slot == NO_SLOT)
+    {
+        return false;
+    }
+
+    // Volume may only be taken away, and not below what has already traded.
+    Order& order = At(slot);
+    const long fillVolume = static_cast<long>(order.mVolume - order.mRemainingVolume);
+    const long keep = std::min(std::max(newVolume, fillVolume), static_cast<long>(order.mVolume));
+    const unsigned long diff = order.mVolume - static_cast<unsigned long>(keep);
+    RemoveVolumeFromLevel(slot, diff);
+    order.mVolume -= diff;
+    order.mRemainingVolume -= diff;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderAmended(now, order, diff);
+    }
+    if (order.mRemainingVolume == 0)
+    {
+        Free(slot);
+    }
+    return true;
+}
+
+bool OrderBook::Cancel(double now, const IOrderListener* listener, unsigned long clientOrderId)
+{
+    const Slot slot = mIndex.Find(listener, clientOrderId);
+    if (slot == NO_SLOT)
+    {
+        return false;
+    }
+
+    Order& order = At(slot);
+    const unsigned long remaining = order.mRemainingVolume;
+    RemoveVolumeFromLevel(slot, remaining);
+    order.mRemainingVolume = 0;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderCancelled(now, order, remaining);
+    }
+    Free(slot);
+    return true;
+}
+
+const Order* OrderBook::Find(const IOrderListener* listener, unsigned long clientOrderId) const
+{
+    const Slot slot = mIndex.Find(listener, clientOrderId);
+    return (slot != NO_SLOT) ? &At(slot) : nullptr;
+}
+
+double OrderBook::MidpointPrice() const
+{
+    if (mAsks.Empty() || mBids.Empty())
+    {
+        return 0.0;
+    }
+    return static_cast<double>(TickPrice(mBids.mBestTick) + TickPrice(mAsks.mBestTick)) / 2.0;
+}
+
+void OrderBook::Place(double now, Slot slot)
+{
+    Order& order = At(slot);
+    if (order.mPrice % mTickSize != 0)
+    {
+        throw ReadyTraderGoError("order price " + std::to_string(order.mPrice) + " is not a multiple of the tick size");
+    }
+
+    BookSide& side = SideOf(order);
+    const long tick = static_cast<long>(order.mPrice / mTickSize);
+    Level& level = side.Get(tick);
+
+    order.mPrevious = level.mTail;
+    order.mNext = NO_SLOT;
+    if (level.mTail != NO_SLOT)
+    {
+        At(level.mTail).mNext = slot;
+    }
+    else
+    {
+        level.mHead = slot;
+    }
+    level.mTail = slot;
+
+    const bool wasEmpty = level.mTotalVolume == 0;
+    level.mTotalVolume += order.mRemainingVolume;
+    if (wasEmpty)
+    {
+        side.Added(tick);
+    }
+
+    mIndex.Insert(order.mListener, order.mClientOrderId, slot);
+    order.mIsResting = true;
+
+    if (order.mListener)
+    {
+        order.mListener->OnOrderPlaced(now, order);
+    }
+}
+
+void OrderBook::Unlink(Level& level, Slot slot)
+{
+    Order& order = At(slot);
+    if (order.mPrevious != NO_SLOT)
+    {
+        At(order.mPrevious).mNext = order.mNext;
+    }
+    else
+    {
+        level.mHead = order.mNext;
+    }
+    if (order.mNext != NO_SLOT)
+    {
+        At(order.mNext).mPrevious = order.mPrevious;
+    }
+    else
+    {
+        level.mTail = order.mPrevious;
+    }
+    order.mPrevious = order.mNext = NO_SLOT;
+}
+
+void OrderBook::RemoveVolumeFromLevel(Slot slot, unsigned long volume)
+{
+    Order& order = At(slot);
+    BookSide& side = SideOf(order);
+    const long tick = static_cast<long>(order.mPrice / mTickSize);
+    Level& level = *side.Find(tick);
+
+    // The exchange leaves an order with nothing remaining in the queue
+    // until a trade reaches it and skips it; here it goes at once.
+    if (order.mRemainingVolume == volume)
+    {
+        Unlink(level, slot);
+    }
+    level.mTotalVolume -= volume;
+    if (volume != 0 && level.mTotalVolume == 0)
+    {
+        side.Emptied(tick);
+    }
+}
+
+void OrderBook::Trade(double now, Slot slot, BookSide& levels)
+{
+    Order& order = At(slot);
+    while (order.mRemainingVolume > 0 && !levels.Empty())
+    {
+        const long tick = levels.mBestTick;
+        const unsigned long price = TickPrice(tick);
+        if ((order.mSide == Side::BUY) ? price > order.mPrice : price < order.mPrice)
+        {
+            break;
+        }
+
+        Level& level = *levels.Find(tick);
+        TradeLevel(now, order, price, level);
+        if (level.mTotalVolume != 0)
+        {
+            break;
+        }
+        levels.Emptied(tick);
+    }
+}
+
+void OrderBook::TradeLevel(double now, Order& order, unsigned long price, Level& level)
+{
+    unsigned long remaining = order.mRemainingVolume;
+    unsigned long totalVolume = level.mTotalVolume;
+
+    while (remaining > 0 && totalVolume > 0)
+    {
+        const Slot passiveSlot = level.mHead;
+        Order& passive = At(passiveSlot);
+        const unsigned long volume = std::min(remaining, passive.mRemainingVolume);
+        const long fee = RoundFee(price, volume, mMakerFee);
+        totalVolume -= volume;
+        remaining -= volume;
+        passive.mRemainingVolume -= volume;
+        passive.mTotalFees += fee;
+
+        if (passive.mRemainingVolume == 0)
+        {
+            Unlink(level, passiveSlot);
+        }
+        if (passive.mListener)
+        {
+            passive.mListener->OnOrderFilled(now, passive, price, volume, fee);
+        }
+        if (passive.mRemainingVolume == 0)
+        {
+            Free(passiveSlot);
+        }
+    }
+
+    level.mTotalVolume = totalVolume;
+    const unsigned long traded = order.mRemainingVolume - remaining;
+    AddTradeTick((order.mSide == Side::BUY) ? mAskTicks : mBidTicks, price, traded);
+
+    const long fee = RoundFee(price, traded, mTakerFee);
+    order.mRemainingVolume = remaining;
+    order.mTotalFees += fee;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderFilled(now, order, price, traded, fee);
+    }
+
+    mLastTradedPrice = price;
+}
+
+void OrderBook::AddTradeTick(std::vector<std::pair<unsigned long, unsigned long>>& ticks,
+                             unsigned long price,
+                             unsigned long volume)
+{
+    // Only a handful of prices trade between publications.
+    for (auto& tick: ticks)
+    {
+        if (tick.first == price)
+        {
+            tick.second += volume;
+            return;
+        }
+    }
+    ticks.emplace_back(price, volume);
+}
+
+void OrderBook::TopLevels(std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                          std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                          std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                          std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) const
+{
+    const auto fill = [this](const BookSide& side, auto& prices, auto& volumes) {
+        prices.fill(0);
+        volumes.fill(0);
+        const std::size_t count = std::min(side.mLevelCount, TOP_LEVEL_COUNT);
+        long tick = side.mBestTick;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (i != 0)
+            {
+                tick = side.Seek(tick + side.Step());
+            }
+            prices[i] = TickPrice(tick);
+            volumes[i] = side.At(tick).mTotalVolume;
+        }
+    };
+
+    fill(mAsks, askPrices, askVolumes);
+    fill(mBids, bidPrices, bidVolumes);
+}
+
+bool OrderBook::TradeTicks(std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                           std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                           std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                           std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    if (mAskTicks.empty() && mBidTicks.empty())
+    {
+        return false;
+    }
+
+    // Lowest ask prices and highest bid prices first.
+    const auto fill = [](auto& ticks, auto& prices, auto& volumes, auto better) {
+        std::sort(ticks.begin(), ticks.end(), better);
+        prices.fill(0);
+        volumes.fill(0);
+        for (std::size_t i = 0; i < ticks.size() && i < TOP_LEVEL_COUNT; ++i)
+        {
+            prices[i] = ticks[i].first;
+            volumes[i] = ticks[i].second;
+        }
+        ticks.clear();
+    };
+
+    fill(mAskTicks, askPrices, askVolumes, [](const auto& a, const auto& b) { return a.first < b.first; });
+    fill(mBidTicks, bidPrices, bidVolumes, [](const auto& a, const auto& b) { return a.first > b.first; });
+    return true;
+}
+
+std::pair<unsigned long, unsigned long> OrderBook::TryTrade(Side side, unsigned long limitPrice, unsigned long volume) const
+{
+    const BookSide& levels = (side == Side::SELL) ? mBids : mAsks;
+    unsigned long totalVolume = 0;
+    unsigned long totalValue = 0;
+
+    long tick = levels.mBestTick;
+    for (std::size_t seen = 0; seen < levels.mLevelCount && totalVolume < volume; ++seen)
+    {
+        if (seen != 0)
+        {
+            tick = levels.Seek(tick + levels.Step());
+        }
+        const unsigned long price = TickPrice(tick);
+        if ((side == Side::BUY) ? price > limitPrice : price < limitPrice)
+        {
+            break;
+        }
+        const unsigned long weight = std::min(volume - totalVolume, levels.At(tick).mTotalVolume);
+        totalVolume += weight;
+        totalValue += weight * price;
+    }
+
+    return {totalVolume, (totalVolume > 0) ? totalValue / totalVolume : 0};
+}
+
+}
@@ -0,0 +1,260 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+struct Order;
+
+// Told what happens to its orders. Times are seconds since the market
+// opened and fees are in cents (negative for a rebate). Listeners must not
+// call back into the book.
+class IOrderListener
+{
+public:
+    virtual ~IOrderListener() = default;
+
+    virtual void OnOrderAmended(double now, const Order& order, unsigned long volumeRemoved) {}
+    virtual void OnOrderCancelled(double now, const Order& order, unsigned long volumeRemoved) {}
+    virtual void OnOrderPlaced(double now, const Order& order) {}
+    virtual void OnOrderFilled(double now, const Order& order, unsigned long price, unsigned long volume, long fee) {}
+};
+
+// An order in an OrderBook, which owns it. An order that has finished is
+// gone once the last callback about it returns.
+struct Order
+{
+    unsigned long mClientOrderId = 0;
+    unsigned long mPrice = 0;
+    unsigned long mVolume = 0;
+    unsigned long mRemainingVolume = 0;
+    long mTotalFees = 0;
+    IOrderListener* mListener = nullptr;
+    Instrument mInstrument = Instrument::ETF;
+    Lifespan mLifespan = Lifespan::GOOD_FOR_DAY;
+    Side mSide = Side::BUY;
+    bool mIsResting = false;
+
+    // The book's: the neighbours in the order's price level queue, or the
+    // next free order.
+    std::uint32_t mPrevious = 0;
+    std::uint32_t mNext = 0;
+};
+
+// Price-time priority matching with the exchange's semantics (see
+// order_book.py), so that a replay sees the same books, trades and fees:
+//   * an aggressive order trades level by level at the resting prices, and
+//     what is left is placed if it is good-for-day and cancelled if not;
+//   * amends only ever take volume away and keep queue position;
+//   * the trade ticks are the volumes traded at each price since they were
+//     last taken, aggressive buys at ask prices and sells at bid prices.
+//
+// Each side is an array of price levels indexed by tick, which grows to
+// span the resting prices up to a window of MAX_GRID_TICKS; levels that lie
+// outside the window, such as far out of the money orders, are kept in a
+// sparse map instead. Each level is an intrusive FIFO queue threaded
+// through orders that live in a pooled arena,
+// and orders are found by listener and client order id through an open
+// addressing hash table, so nothing allocates once the book has warmed up.
+// Resting prices must lie on the tick grid.
+class OrderBook
+{
+public:
+    static constexpr std::size_t MAX_GRID_TICKS = std::size_t{1} << 20;
+
+    OrderBook(Instrument instrument, unsigned long tickSize, double makerFee, double takerFee);
+
+    // Client order ids must be unique for each listener (which may be null)
+    // while their orders rest. Returns false, doing nothing, if the id is
+    // already resting.
+    bool Insert(double now,
+                IOrderListener* listener,
+                unsigned long clientOrderId,
+                Side side,
+                unsigned long price,
+                unsigned long volume,
+                Lifespan lifespan);
+
+    // Return false if there is no such resting order.
+    bool Amend(double now, const IOrderListener* listener, unsigned long clientOrderId, long newVolume);
+    bool Cancel(double now, const IOrderListener* listener, unsigned long clientOrderId);
+
+    // Null if there is no such resting order.
+    const Order* Find(const IOrderListener* listener, unsigned long clientOrderId) const;
+
+    // Zero if there is no such price.
+    unsigned long BestAsk() const { return mAsks.Empty() ? 0 : TickPrice(mAsks.mBestTick); }
+    unsigned long BestBid() const { return mBids.Empty() ? 0 : TickPrice(mBids.mBestTick); }
+    unsigned long LastTradedPrice() const { return mLastTradedPrice; }
+    double MidpointPrice() const;
+
+    Instrument GetInstrument() const { return mInstrument; }
+
+    // The best TOP_LEVEL_COUNT prices and their volumes, zero filled.
+    void TopLevels(std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                   std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                   std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                   std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) const;
+
+    // If there have been trades since the last call, fill in the trade
+    // ticks, forget them and return true.
+    bool TradeTicks(std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                    std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                    std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                    std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes);
+
+    // The volume that would trade, and its average price per lot rounded
+    // down, for an order of the given side, limit price and volume. The
+    // book is not changed.
+    std::pair<unsigned long, unsigned long> TryTrade(Side side, unsigned long limitPrice, unsigned long volume) const;
+
+private:
+    using Slot = std::uint32_t;
+    static constexpr Slot NO_SLOT = 0;
+
+    static constexpr unsigned CHUNK_SHIFT = 12;
+    static constexpr Slot CHUNK_MASK = (Slot{1} << CHUNK_SHIFT) - 1;
+
+    struct Level
+    {
+        Slot mHead = NO_SLOT;
+        Slot mTail = NO_SLOT;
+        unsigned long mTotalVolume = 0;
+    };
+
+    // One side's levels. A level is in the book while it has volume; the
+    // best tick is only meaningful while some level is. Levels in the
+    // overflow map are only there while they have volume.
+    struct BookSide
+    {
+        explicit BookSide(bool ascending) : mAscending(ascending) {}
+
+        bool Empty() const { return mLevelCount == 0; }
+        long Step() const { return mAscending ? 1 : -1; }
+        bool Better(long tick, long than) const { return mAscending ? tick < than : tick > than; }
+        bool InWindow(long tick) const
+        {
+            return tick >= mBaseTick && tick - mBaseTick < static_cast<long>(mLevels.size());
+        }
+
+        Level* Find(long tick)
+        {
+            if (InWindow(tick))
+            {
+                return &mLevels[tick - mBaseTick];
+            }
+            auto it = mOverflow.find(tick);
+            return (it != mOverflow.end()) ? &it->second : nullptr;
+        }
+        const Level& At(long tick) const
+        {
+            return InWindow(tick) ? mLevels[tick - mBaseTick] : mOverflow.at(tick);
+        }
+
+        // The level for the tick, growing the window to reach it if it can.
+        Level& Get(long tick);
+        void Added(long tick);
+        void Emptied(long tick);
+
+        // The first tick with volume, starting from the given one and going
+        // away from the best. There must be one.
+        long Seek(long from) const;
+
+        std::vector<Level> mLevels;
+        std::map<long, Level> mOverflow;
+        long mBaseTick = 0;
+        long mBestTick = 0;
+        std::size_t mLevelCount = 0;
+        std::size_t mWindowLevelCount = 0;
+        bool mAscending;
+    };
+
+    // Resting orders by listener and client order id.
+    class OrderIndex
+    {
+    public:
+        OrderIndex();
+
+        Slot Find(const IOrderListener* listener, unsigned long clientOrderId) const;
+        void Insert(const IOrderListener* listener, unsigned long clientOrderId, Slot slot);
+        void Erase(const IOrderListener* listener, unsigned long clientOrderId);
+
+    private:
+        struct Entry
+        {
+            unsigned long mClientOrderId = 0;
+            const IOrderListener* mListener = nullptr;
+            Slot mSlot = NO_SLOT;
+        };
+
+        std::size_t Home(const IOrderListener* listener, unsigned long clientOrderId) const;
+        void Grow();
+
+        std::vector<Entry> mEntries;
+        std::size_t mMask;
+        std::size_t mSize = 0;
+    };
+
+    Order& At(Slot slot) { return mChunks[slot >> CHUNK_SHIFT][slot & CHUNK_MASK]; }
+    const Order& At(Slot slot) const { return mChunks[slot >> CHUNK_SHIFT][slot & CHUNK_MASK]; }
+    Slot Allocate();
+    void Free(Slot slot);
+
+    unsigned long TickPrice(long tick) const { return static_cast<unsigned long>(tick) * mTickSize; }
+    BookSide& SideOf(const Order& order) { return (order.mSide == Side::SELL) ? mAsks : mBids; }
+
+    void Place(double now, Slot slot);
+    void Unlink(Level& level, Slot slot);
+    void RemoveVolumeFromLevel(Slot slot, unsigned long volume);
+    void Trade(double now, Slot slot, BookSide& levels);
+    void TradeLevel(double now, Order& order, unsigned long price, Level& level);
+    void AddTradeTick(std::vector<std::pair<unsigned long, unsigned long>>& ticks, unsigned long price,
+                      unsigned long volume);
+
+    Instrument mInstrument;
+    unsigned long mTickSize;
+    double mMakerFee;
+    double mTakerFee;
+
+    BookSide mAsks{true};
+    BookSide mBids{false};
+    OrderIndex mIndex;
+
+    std::vector<std::unique_ptr<Order[]>> mChunks;
+    Slot mFreeSlots = NO_SLOT;
+    Slot mNextSlot = 1;
+
+    std::vector<std::pair<unsigned long, unsigned long>> mAskTicks;
+    std::vector<std::pair<unsigned long, unsigned long>> mBidTicks;
+    unsigned long mLastTradedPrice = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
@@ -0,0 +1,549 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#include <ready_trader_go/protocol.h>
+
+#include "simulatedexchange.h"
+
+namespace ReadyTraderGo {
+
+SimulatedExchange::SimulatedExchange(const SimulatorConfig& config, MarketEventSource& events)
+    : mConfig(config),
+      mEvents(events),
+      mHaveEvent(events.Next(mNextEvent)),
+      mBooks{OrderBook{Instrument::FUTURE, config.mLimits.mTickSize, 0.0, 0.0},
+             OrderBook{Instrument::ETF, config.mLimits.mTickSize, config.mMakerFee, config.mTakerFee}},
+      mAccount(config.mLimits.mTickSize, config.mLimits.mEtfClamp),
+      mFrequencyLimiter(config.mLimits.mMessageFrequencyInterval, config.mLimits.mMessageFrequencyLimit)
+{
+}
+
+void SimulatedExchange::ProcessMarketEvents(double now)
+{
+    for (; mHaveEvent && mNextEvent.mTime < now; mHaveEvent = mEvents.Next(mNextEvent))
+    {
+        const MarketEvent& event = mNextEvent;
+        ++mEventsProcessed;
+        const auto instrument = static_cast<int>(event.mInstrument);
+        OrderBook& book = mBooks[instrument];
+
+        // Market orders have no listener. Their ids are never reused in the
+        // market data; if one were while the first order still rested, the
+        // book would ignore the second insert.
+        switch (event.mOperation)
+        {
+        case MarketEventOperation::INSERT:
+            book.Insert(event.mTime, nullptr, event.mOrderId, event.mSide, event.mPrice,
+                        static_cast<unsigned long>(std::labs(event.mVolume)), event.mLifespan);
+            break;
+        case MarketEventOperation::CANCEL:
+            book.Cancel(event.mTime, nullptr, event.mOrderId);
+            break;
+        case MarketEventOperation::AMEND:
+            if (const Order* order = book.Find(nullptr, event.mOrderId); order && event.mVolume < 0)
+            {
+                book.Amend(event.mTime, nullptr, event.mOrderId, static_cast<long>(order->mVolume) + event.mVolume);
+            }
+            break;
+        }
+    }
+
+    SendTradeTicks();
+}
+
+void SimulatedExchange::Tick(double now, unsigned long tickNumber)
+{
+    const OrderBook& future = mBooks[static_cast<int>(Instrument::FUTURE)];
+    const OrderBook& etf = mBooks[static_cast<int>(Instrument::ETF)];
+    mAccount.Update(static_cast<long>(future.LastTradedPrice()), static_cast<long>(etf.LastTradedPrice()));
+
+    for (const OrderBook& book: mBooks)
+    {
+        OrderBookMessage message;
+        message.mInstrument = book.GetInstrument();
+        message.mSequenceNumber = tickNumber;
+        book.TopLevels(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes);
+        Send(SimulatedChannel::INFORMATION, MessageType::ORDER_BOOK_UPDATE, message);
+    }
+}
+
+void SimulatedExchange::CheckUnhedgedLots(double now)
+{
+    if (mUnhedgedLotsDeadline >= 0.0 && now >= mUnhedgedLotsDeadline)
+    {
+        mUnhedgedLotsDeadline = -1.0;
+        HardBreach(0, "held unhedged lots for longer than the time limit");
+    }
+}
+
+void SimulatedExchange::OnMessage(double now, unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    if (!mConnected)
+    {
+        return;
+    }
+
+    // As in the exchange, every message brings the market up to date first.
+    ProcessMarketEvents(now);
+    ++mStats.mMessagesReceived;
+
+    if (mFrequencyLimiter.CheckEvent(now))
+    {
+        if (mLoggedIn)
+        {
+            HardBreach(0, "message frequency limit breached");
+        }
+        else
+        {
+            Close();
+        }
+        return;
+    }
+
+    if (!mLoggedIn)
+    {
+        if (messageType == MessageType::LOGIN)
+        {
+            OnLogin(data, size);
+        }
+        else
+        {
+            Close();
+        }
+        return;
+    }
+
+    switch (messageType)
+    {
+    case MessageType::AMEND_ORDER:
+        OnAmend(now, data, size);
+        break;
+    case MessageType::CANCEL_ORDER:
+        OnCancel(now, data, size);
+        break;
+    case MessageType::HEDGE_ORDER:
+        OnHedge(now, data, size);
+        break;
+    case MessageType::INSERT_ORDER:
+        OnInsert(now, data, size);
+        break;
+    default:
+        Close();
+        break;
+    }
+
+    SendTradeTicks();
+}
+
+void SimulatedExchange::Disconnect(double now)
+{
+    mConnected = false;
+    const std::set<unsigned long> orders = mLiveOrders;
+    for (unsigned long clientOrderId: orders)
+    {
+        mBooks[static_cast<int>(Instrument::ETF)].Cancel(now, this, clientOrderId);
+    }
+    SendTradeTicks();
+}
+
+void SimulatedExchange::OnLogin(unsigned char const* data, std::size_t size)
+{
+    LoginMessage login;
+    if (size != login.Size())
+    {
+        Close();
+        return;
+    }
+    login.Deserialise(data, size);
+
+    auto trader = mConfig.mTraders.find(login.mName);
+    if (!mConfig.mTraders.empty() && (trader == mConfig.mTraders.end() || trader->second != login.mSecret))
+    {
+        Close();
+        return;
+    }
+    mLoggedIn = true;
+}
+
+void SimulatedExchange::OnAmend(double now, unsigned char const* data, std::size_t size)
+{
+    AmendMessage amend;
+    if (size != amend.Size())
+    {
+        Close();
+        return;
+    }
+    amend.Deserialise(data, size);
+    ++mStats.mAmends;
+
+    if (static_cast<long>(amend.mClientOrderId) > mLastClientOrderId)
+    {
+        SendError(amend.mClientOrderId, "out-of-order client_order_id in amend message");
+        return;
+    }
+
+    OrderBook& etf = mBooks[static_cast<int>(Instrument::ETF)];
+    if (const Order* order = etf.Find(this, amend.mClientOrderId))
+    {
+        if (amend.mNewVolume > order->mVolume)
+        {
+            SendError(amend.mClientOrderId, "amend operation would increase order volume");
+        }
+        else
+        {
+            etf.Amend(now, this, amend.mClientOrderId, static_cast<long>(amend.mNewVolume));
+        }
+    }
+}
+
+void SimulatedExchange::OnCancel(double now, unsigned char const* data, std::size_t size)
+{
+    CancelMessage cancel;
+    if (size != cancel.Size())
+    {
+        Close();
+        return;
+    }
+    cancel.Deserialise(data, size);
+    ++mStats.mCancels;
+
+    if (static_cast<long>(cancel.mClientOrderId) > mLastClientOrderId)
+    {
+        SendError(cancel.mClientOrderId, "out-of-order client_order_id in cancel message");
+        return;
+    }
+
+    mBooks[static_cast<int>(Instrument::ETF)].Cancel(now, this, cancel.mClientOrderId);
+}
+
+void SimulatedExchange::OnHedge(double now, unsigned char const* data, std::size_t size)
+{
+    HedgeMessage hedge;
+    if (size != hedge.Size())
+    {
+        Close();
+        return;
+    }
+    hedge.Deserialise(data, size);
+    ++mStats.mHedges;
+
+    const unsigned long clientOrderId = hedge.mClientOrderId;
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+    mLastClientOrderId = static_cast<long>(clientOrderId);
+
+    if (hedge.mSide != Side::BUY && hedge.mSide != Side::SELL)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(hedge.mSide)) + " is not a valid side");
+        return;
+    }
+    if (hedge.mPrice < MINIMUM_BID || hedge.mPrice > MAXIMUM_ASK)
+    {
+        SendError(clientOrderId, std::to_string(hedge.mPrice) + " is not a valid price");
+        return;
+    }
+    if (hedge.mPrice % mConfig.mLimits.mTickSize != 0)
+    {
+        SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+    if (hedge.mVolume < 1)
+    {
+        SendError(clientOrderId, std::to_string(hedge.mVolume) + " is not a valid volume");
+        return;
+    }
+    if (now == 0.0)
+    {
+        SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+
+    const OrderBook& future = mBooks[static_cast<int>(Instrument::FUTURE)];
+    const OrderBook& etf = mBooks[static_cast<int>(Instrument::ETF)];
+    auto [volumeTraded, averagePrice] = future.TryTrade(hedge.mSide, hedge.mPrice, hedge.mVolume);
+    if (volumeTraded == 0)
+    {
+        // There may have been nothing on the other side at all, in which
+        // case the hedge goes through at the last traded price.
+        const unsigned long best = (hedge.mSide == Side::BUY) ? future.BestAsk() : future.BestBid();
+        if (best == 0)
+        {
+            const unsigned long lastTraded = future.LastTradedPrice();
+            if (lastTraded == 0)
+            {
+                SendError(clientOrderId, "order rejected: cannot determine future price");
+                return;
+            }
+            if ((hedge.mSide == Side::SELL && lastTraded >= hedge.mPrice)
+                || (hedge.mSide == Side::BUY && lastTraded <= hedge.mPrice))
+            {
+                averagePrice = lastTraded;
+            }
+        }
+    }
+
+    if (averagePrice == 0)
+    {
+        Send(SimulatedChannel::EXECUTION, MessageType::HEDGE_FILLED, HedgeFilledMessage{clientOrderId, 0, 0});
+        return;
+    }
+
+    const long volume = static_cast<long>(hedge.mVolume);
+    ApplyPositionDelta(now, (hedge.mSide == Side::BUY) ? volume : -volume);
+    mAccount.Transact(Instrument::FUTURE, hedge.mSide, averagePrice, hedge.mVolume, 0);
+    const unsigned long futurePrice = future.LastTradedPrice();
+    const unsigned long etfPrice = etf.LastTradedPrice();
+    mAccount.Update(futurePrice ? static_cast<long>(futurePrice) : std::lround(future.MidpointPrice()),
+                    etfPrice ? static_cast<long>(etfPrice) : std::lround(etf.MidpointPrice()));
+
+    Send(SimulatedChannel::EXECUTION, MessageType::HEDGE_FILLED,
+         HedgeFilledMessage{clientOrderId, averagePrice, hedge.mVolume});
+
+    if (std::labs(mAccount.mFuturePosition) > mConfig.mLimits.mPositionLimit)
+    {
+        HardBreach(clientOrderId, "future position limit breached");
+    }
+}
+
+void SimulatedExchange::OnInsert(double now, unsigned char const* data, std::size_t size)
+{
+    InsertMessage insert;
+    if (size != insert.Size())
+    {
+        Close();
+        return;
+    }
+    insert.Deserialise(data, size);
+    ++mStats.mInserts;
+
+    const unsigned long clientOrderId = insert.mClientOrderId;
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+    mLastClientOrderId = static_cast<long>(clientOrderId);
+
+    if (insert.mSide != Side::BUY && insert.mSide != Side::SELL)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(insert.mSide)) + " is not a valid side");
+        return;
+    }
+    if (insert.mLifespan != Lifespan::FILL_AND_KILL && insert.mLifespan != Lifespan::GOOD_FOR_DAY)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(insert.mLifespan)) + " is not a valid lifespan");
+        return;
+    }
+    if (insert.mPrice < MINIMUM_BID || insert.mPrice > MAXIMUM_ASK)
+    {
+        SendError(clientOrderId, std::to_string(insert.mPrice) + " is not a valid price");
+        return;
+    }
+    if (insert.mPrice % mConfig.mLimits.mTickSize != 0)
+    {
+        SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+    if (mLiveOrders.size() == mConfig.mLimits.mActiveOrderCountLimit)
+    {
+        SendError(clientOrderId, "order rejected: active order count limit breached");
+        return;
+    }
+    if (insert.mVolume < 1)
+    {
+        SendError(clientOrderId, std::to_string(insert.mVolume) + " is not a valid volume");
+        return;
+    }
+    if (mActiveVolume + insert.mVolume > mConfig.mLimits.mActiveVolumeLimit)
+    {
+        SendError(clientOrderId, "order rejected: active order volume limit breached");
+        return;
+    }
+    if (now == 0.0)
+    {
+        SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+    if ((insert.mSide == Side::BUY && !mSellPrices.empty() && insert.mPrice >= *mSellPrices.begin())
+        || (insert.mSide == Side::SELL && !mBuyPrices.empty() && insert.mPrice <= *mBuyPrices.rbegin()))
+    {
+        SendError(clientOrderId, "order rejected: in cross with an existing order");
+        return;
+    }
+
+    mLiveOrders.insert(clientOrderId);
+    ((insert.mSide == Side::BUY) ? mBuyPrices : mSellPrices).insert(insert.mPrice);
+    mActiveVolume += insert.mVolume;
+    mBooks[static_cast<int>(Instrument::ETF)].Insert(now, this, clientOrderId, insert.mSide, insert.mPrice,
+                                                      insert.mVolume, insert.mLifespan);
+}
+
+void SimulatedExchange::OnOrderAmended(double now, const Order& order, unsigned long volumeRemoved)
+{
+    SendOrderStatus(order, order.mVolume - order.mRemainingVolume);
+    mActiveVolume -= volumeRemoved;
+    if (order.mRemainingVolume == 0)
+    {
+        ForgetOrder(order);
+    }
+}
+
+void SimulatedExchange::OnOrderCancelled(double now, const Order& order, unsigned long volumeRemoved)
+{
+    SendOrderStatus(order, order.mVolume - volumeRemoved);
+    mActiveVolume -= volumeRemoved;
+    ForgetOrder(order);
+}
+
+void SimulatedExchange::OnOrderPlaced(double now, const Order& order)
+{
+    // Only if the order has not already partially filled.
+    if (order.mVolume == order.mRemainingVolume)
+    {
+        SendOrderStatus(order, 0);
+    }
+}
+
+void SimulatedExchange::OnOrderFilled(double now, const Order& order, unsigned long price, unsigned long volume, long fee)
+{
+    mActiveVolume -= volume;
+    if (order.mRemainingVolume == 0)
+    {
+        ForgetOrder(order);
+    }
+
+    ++mStats.mFills;
+    ApplyPositionDelta(now, (order.mSide == Side::BUY) ? static_cast<long>(volume) : -static_cast<long>(volume));
+
+    const OrderBook& future = mBooks[static_cast<int>(Instrument::FUTURE)];
+    const unsigned long futurePrice = future.LastTradedPrice();
+    mAccount.Transact(Instrument::ETF, order.mSide, price, volume, fee);
+    mAccount.Update(futurePrice ? static_cast<long>(futurePrice) : std::lround(future.MidpointPrice()),
+                    static_cast<long>(price));
+    mStats.mMaxEtfPosition = std::max(mStats.mMaxEtfPosition, std::labs(mAccount.mEtfPosition));
+
+    Send(SimulatedChannel::EXECUTION, MessageType::ORDER_FILLED, OrderFilledMessage{order.mClientOrderId, price, volume});
+    SendOrderStatus(order, order.mVolume - order.mRemainingVolume);
+
+    if (std::labs(mAccount.mEtfPosition) > mConfig.mLimits.mPositionLimit)
+    {
+        HardBreach(order.mClientOrderId, "ETF position limit breached");
+    }
+}
+
+void SimulatedExchange::ApplyPositionDelta(double now, long delta)
+{
+    // The clock starts when the relative position goes beyond the limit
+    // and stops when it comes back within it (see unhedged_lots.py).
+    const long before = mRelativePosition;
+    mRelativePosition += delta;
+    if (delta > 0)
+    {
+        if (before < -MAX_UNHEDGED_LOTS && -MAX_UNHEDGED_LOTS <= mRelativePosition)
+        {
+            mUnhedgedLotsDeadline = -1.0;
+        }
+        if (mRelativePosition > MAX_UNHEDGED_LOTS && MAX_UNHEDGED_LOTS >= before)
+        {
+            mUnhedgedLotsDeadline = now + UNHEDGED_LOTS_TIME_LIMIT;
+        }
+    }
+    else if (delta < 0)
+    {
+        if (before > MAX_UNHEDGED_LOTS && MAX_UNHEDGED_LOTS >= mRelativePosition)
+        {
+            mUnhedgedLotsDeadline = -1.0;
+        }
+        if (mRelativePosition < -MAX_UNHEDGED_LOTS && -MAX_UNHEDGED_LOTS <= before)
+        {
+            mUnhedgedLotsDeadline = now + UNHEDGED_LOTS_TIME_LIMIT;
+        }
+    }
+}
+
+void SimulatedExchange::ForgetOrder(const Order& order)
+{
+    auto& prices = (order.mSide == Side::BUY) ? mBuyPrices : mSellPrices;
+    prices.erase(prices.find(order.mPrice));
+    mLiveOrders.erase(order.mClientOrderId);
+}
+
+void SimulatedExchange::HardBreach(unsigned long clientOrderId, const std::string& message)
+{
+    mStatus = "BREACH";
+    if (mConnected)
+    {
+        SendError(clientOrderId, message);
+        Close();
+    }
+}
+
+void SimulatedExchange::Close()
+{
+    // The connection is closed after whatever has been sent so far; the
+    // caller finds out from IsConnected and calls Disconnect.
+    mConnected = false;
+}
+
+void SimulatedExchange::Send(SimulatedChannel channel, unsigned char messageType, const ISerialisable& message)
+{
+    if (channel == SimulatedChannel::EXECUTION && !mConnected)
+    {
+        return;
+    }
+    SimulatedMessage& out = mOutbox.emplace_back();
+    out.mChannel = channel;
+    out.mType = messageType;
+    out.mSize = message.Size();
+    message.Serialise(out.mData.data());
+}
+
+void SimulatedExchange::SendError(unsigned long clientOrderId, const std::string& message)
+{
+    ++mStats.mErrors;
+    Send(SimulatedChannel::EXECUTION, MessageType::ERROR_MESSAGE, ErrorMessage{clientOrderId, message});
+}
+
+void SimulatedExchange::SendOrderStatus(const Order& order, unsigned long fillVolume)
+{
+    Send(SimulatedChannel::EXECUTION, MessageType::ORDER_STATUS,
+         OrderStatusMessage{order.mClientOrderId, fillVolume, order.mRemainingVolume, order.mTotalFees});
+}
+
+void SimulatedExchange::SendTradeTicks()
+{
+    for (OrderBook& book: mBooks)
+    {
+        TradeTicksMessage message;
+        if (book.TradeTicks(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes))
+        {
+            message.mInstrument = book.GetInstrument();
+            message.mSequenceNumber = ++mTradeTicksSequences[static_cast<int>(book.GetInstrument())];
+            Send(SimulatedChannel::INFORMATION, MessageType::TRADE_TICKS, message);
+        }
+    }
+}
+
+}
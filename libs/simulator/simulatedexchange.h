@@ -0,0 +1,212 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDEXCHANGE_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDEXCHANGE_H
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/connectivitytypes.h>
+#include <ready_trader_go/limits.h>
+#include <ready_trader_go/types.h>
+
+#include "account.h"
+#include "frequencylimiter.h"
+#include "marketdata.h"
+#include "orderbook.h"
+
+namespace ReadyTraderGo {
+
+// The exchange settings a simulation needs (see exchange.json).
+struct SimulatorConfig
+{
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        mMarketDataFile = tree.get<std::string>("Engine.MarketDataFile", mMarketDataFile);
+        mMarketEventInterval = tree.get<double>("Engine.MarketEventInterval", mMarketEventInterval);
+        mTickInterval = tree.get<double>("Engine.TickInterval", mTickInterval);
+        mMakerFee = tree.get<double>("Fees.Maker", mMakerFee);
+        mTakerFee = tree.get<double>("Fees.Taker", mTakerFee);
+        mInformationLatency = tree.get<double>("Latency.InformationPublish", mInformationLatency);
+        mOrderEntryLatency = tree.get<double>("Latency.OrderEntry", mOrderEntryLatency);
+        mExecutionReportLatency = tree.get<double>("Latency.ExecutionReport", mExecutionReportLatency);
+        mLimits.readFromPropertyTree(tree);
+        if (auto traders = tree.get_child_optional("Traders"))
+        {
+            for (const auto& trader: *traders)
+            {
+                mTraders[trader.first] = trader.second.get_value<std::string>();
+            }
+        }
+    }
+
+    std::string mMarketDataFile = "data/market_data.csv";
+    double mMarketEventInterval = 0.05;
+    double mTickInterval = 0.25;
+    double mMakerFee = -0.0001;
+    double mTakerFee = 0.0002;
+
+    // One-way latencies, in seconds, applied by a Backtest: from the
+    // exchange publishing information to the competitor receiving it, from
+    // the competitor sending a message to the exchange handling it, and from
+    // the exchange replying to the competitor receiving the reply.
+    double mInformationLatency = 0.0;
+    double mOrderEntryLatency = 0.0;
+    double mExecutionReportLatency = 0.0;
+    ExchangeLimits mLimits;
+    std::map<std::string, std::string> mTraders;
+};
+
+enum class SimulatedChannel : unsigned char
+{
+    EXECUTION,
+    INFORMATION
+};
+
+// The largest message payload the exchange sends.
+constexpr std::size_t MAX_SIMULATED_MESSAGE_SIZE = 128;
+
+// A message from the exchange to the competitor, serialised as it would be
+// on the wire (less the header) and waiting to be delivered.
+struct SimulatedMessage
+{
+    SimulatedChannel mChannel = SimulatedChannel::EXECUTION;
+    unsigned char mType = 0;
+    std::size_t mSize = 0;
+    std::array<unsigned char, MAX_SIMULATED_MESSAGE_SIZE> mData = {};
+};
+
+// What the competitor did, as seen by the exchange.
+struct SimulatedExchangeStats
+{
+    unsigned long mMessagesReceived = 0;
+    unsigned long mInserts = 0;
+    unsigned long mAmends = 0;
+    unsigned long mCancels = 0;
+    unsigned long mHedges = 0;
+    unsigned long mFills = 0;
+    unsigned long mErrors = 0;
+    long mMaxEtfPosition = 0;                   // Largest absolute ETF position.
+};
+
+// A single-competitor, in-process stand-in for the exchange. It replays
+// market events into a pair of OrderBooks and applies the competitor's
+// messages with the same checks, fees, replies and breaches as the Python
+// exchange (see competitor.py and execution.py).
+//
+// The exchange does nothing by itself: the caller moves time forward with
+// ProcessMarketEvents, Tick and CheckUnhedgedLots, passes it the
+// competitor's messages and delivers whatever appears in the outbox. Times
+// are seconds since the market opened.
+class SimulatedExchange : private IOrderListener
+{
+public:
+    // Lots of one instrument held unhedged for longer than this is a breach.
+    static constexpr long MAX_UNHEDGED_LOTS = 10;
+    static constexpr double UNHEDGED_LOTS_TIME_LIMIT = 60.0;
+
+    // The events must outlive the exchange.
+    SimulatedExchange(const SimulatorConfig& config, MarketEventSource& events);
+
+    // Apply every market event before the given time.
+    void ProcessMarketEvents(double now);
+    bool MarketEventsDone() const { return !mHaveEvent; }
+
+    // Mark the competitor's account to market and publish both order books.
+    void Tick(double now, unsigned long tickNumber);
+
+    // Breach the competitor if it has held unhedged lots for too long.
+    void CheckUnhedgedLots(double now);
+
+    // A message (without its header) from the competitor.
+    void OnMessage(double now, unsigned char messageType, unsigned char const* data, std::size_t size);
+
+    // The competitor has gone; its orders are cancelled.
+    void Disconnect(double now);
+
+    // True until the exchange closes the execution connection or the
+    // competitor disconnects.
+    bool IsConnected() const { return mConnected; }
+
+    // Messages for the competitor, oldest first.
+    std::deque<SimulatedMessage>& Outbox() { return mOutbox; }
+
+    const CompetitorAccount& GetAccount() const { return mAccount; }
+    const OrderBook& GetOrderBook(Instrument instrument) const { return mBooks[static_cast<int>(instrument)]; }
+    const SimulatedExchangeStats& GetStats() const { return mStats; }
+    const std::string& GetStatus() const { return mStatus; }
+    std::size_t EventsProcessed() const { return mEventsProcessed; }
+
+private:
+    void OnOrderAmended(double now, const Order& order, unsigned long volumeRemoved) override;
+    void OnOrderCancelled(double now, const Order& order, unsigned long volumeRemoved) override;
+    void OnOrderPlaced(double now, const Order& order) override;
+    void OnOrderFilled(double now, const Order& order, unsigned long price, unsigned long volume, long fee) override;
+
+    void OnLogin(unsigned char const* data, std::size_t size);
+    void OnAmend(double now, unsigned char const* data, std::size_t size);
+    void OnCancel(double now, unsigned char const* data, std::size_t size);
+    void OnHedge(double now, unsigned char const* data, std::size_t size);
+    void OnInsert(double now, unsigned char const* data, std::size_t size);
+
+    void ApplyPositionDelta(double now, long delta);
+    void ForgetOrder(const Order& order);
+    void HardBreach(unsigned long clientOrderId, const std::string& message);
+    void Close();
+    void Send(SimulatedChannel channel, unsigned char messageType, const ISerialisable& message);
+    void SendError(unsigned long clientOrderId, const std::string& message);
+    void SendOrderStatus(const Order& order, unsigned long fillVolume);
+    void SendTradeTicks();
+
+    SimulatorConfig mConfig;
+    MarketEventSource& mEvents;
+    MarketEvent mNextEvent;
+    bool mHaveEvent;
+    std::size_t mEventsProcessed = 0;
+
+    std::array<OrderBook, 2> mBooks;
+    std::array<unsigned long, 2> mTradeTicksSequences = {1, 1};
+
+    // The competitor.
+    bool mConnected = true;
+    bool mLoggedIn = false;
+    std::string mStatus = "OK";
+    CompetitorAccount mAccount;
+    FrequencyLimiter mFrequencyLimiter;
+    long mLastClientOrderId = -1;
+    unsigned long mActiveVolume = 0;
+    std::set<unsigned long> mLiveOrders;
+    std::multiset<unsigned long> mBuyPrices;
+    std::multiset<unsigned long> mSellPrices;
+    long mRelativePosition = 0;
+    double mUnhedgedLotsDeadline = -1.0;      // Negative when not running.
+    SimulatedExchangeStats mStats;
+
+    std::deque<SimulatedMessage> mOutbox;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDEXCHANGE_H
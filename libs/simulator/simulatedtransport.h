@@ -0,0 +1,77 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDTRANSPORT_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDTRANSPORT_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include <ready_trader_go/connectivitytypes.h>
+
+#include "simulatedexchange.h"
+
+namespace ReadyTraderGo {
+
+// An execution connection that hands each message straight to a sink (the
+// payload is serialised exactly as it would be for the wire) and delivers
+// the exchange's replies only when told to.
+class SimulatedConnection : public IConnection
+{
+public:
+    using Sink = std::function<void(unsigned char, unsigned char const*, std::size_t)>;
+
+    explicit SimulatedConnection(Sink sink) : mSink(std::move(sink)) {}
+
+    void AsyncRead() override {}
+
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode) override
+    {
+        std::array<unsigned char, MAX_SIMULATED_MESSAGE_SIZE> buffer;
+        const std::size_t size = serialisable.Size();
+        serialisable.Serialise(buffer.data());
+        mSink(messageType, buffer.data(), size);
+    }
+
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+
+    void Close() { OnDisconnect(); }
+
+private:
+    Sink mSink;
+};
+
+// An information subscription whose messages are delivered only when told.
+class SimulatedSubscription : public ISubscription
+{
+public:
+    void AsyncReceive() override {}
+
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATEDTRANSPORT_H
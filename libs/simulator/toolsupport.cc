@@ -0,0 +1,47 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <iostream>
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include "toolsupport.h"
+
+namespace ReadyTraderGo {
+
+bool IsMarketDataCsv(const std::string& filename)
+{
+    const std::string extension = ".csv";
+    return filename.size() >= extension.size()
+           && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool ReadJsonFile(const std::string& filename, boost::property_tree::ptree& tree)
+{
+    try
+    {
+        boost::property_tree::read_json(filename, tree);
+        return true;
+    }
+    catch (const boost::property_tree::json_parser_error& e)
+    {
+        std::cerr << "failed while reading configuration file '" << filename << "': " << e.message() << std::endl;
+        return false;
+    }
+}
+
+}
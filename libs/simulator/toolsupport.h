@@ -0,0 +1,40 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_TOOLSUPPORT_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_TOOLSUPPORT_H
+
+#include <string>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace ReadyTraderGo {
+
+// Helpers shared by the command line tools built on the simulator.
+
+// True if the market data file is a CSV file, which is parsed, rather than
+// one made by mdconvert, which is mapped. They are told apart by the .csv
+// extension.
+bool IsMarketDataCsv(const std::string& filename);
+
+// Read a JSON configuration file. If it cannot be read, say why on standard
+// error and return false.
+bool ReadJsonFile(const std::string& filename, boost::property_tree::ptree& tree);
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_TOOLSUPPORT_H
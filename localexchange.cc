@@ -0,0 +1,136 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/error.h>
+#include <simulator/exchangeserver.h>
+#include <simulator/marketdata.h>
+#include <simulator/marketdatafile.h>
+#include <simulator/toolsupport.h>
+
+// Runs a local stand-in for the exchange that the unmodified autotrader can
+// connect to, for end-to-end latency and integration testing without
+// Python. Takes the exchange configuration (for the execution port, the
+// information file, the market data file, speed, fees and limits) and,
+// optionally, a market data file to use instead:
+//
+//     localexchange [exchange.json] [market_data.csv]
+//
+// One competitor may connect; its name and secret are checked against
+// Traders. The market opens MarketOpenDelay seconds after it connects and the
+// exchange exits, printing how the competitor did, when the market data runs
+// out or the competitor goes. As with backtest, a market data file that does
+// not end in .csv is taken to be one made by mdconvert.
+int main(int argc, char* argv[])
+{
+    const std::string configFilename = (argc > 1) ? argv[1] : "exchange.json";
+    boost::property_tree::ptree exchangeTree;
+    if (!ReadyTraderGo::ReadJsonFile(configFilename, exchangeTree))
+    {
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        ReadyTraderGo::SimulatorConfig simulatorConfig;
+        simulatorConfig.readFromPropertyTree(exchangeTree);
+        if (argc > 2)
+        {
+            simulatorConfig.mMarketDataFile = argv[2];
+        }
+
+        ReadyTraderGo::ExchangeServerConfig serverConfig;
+        serverConfig.readFromPropertyTree(exchangeTree);
+
+        const std::string& filename = simulatorConfig.mMarketDataFile;
+        std::vector<ReadyTraderGo::MarketEvent> csvEvents;
+        std::unique_ptr<ReadyTraderGo::MarketDataFile> mappedEvents;
+        std::unique_ptr<ReadyTraderGo::MarketEventSource> events;
+        if (ReadyTraderGo::IsMarketDataCsv(filename))
+        {
+            csvEvents = ReadyTraderGo::ReadMarketDataCsv(filename);
+            events = std::make_unique<ReadyTraderGo::MarketEventVectorSource>(csvEvents);
+        }
+        else
+        {
+            mappedEvents = std::make_unique<ReadyTraderGo::MarketDataFile>(filename);
+            events = std::make_unique<ReadyTraderGo::MarketDataFile::Cursor>(mappedEvents->Events());
+        }
+
+        boost::asio::io_context context;
+        ReadyTraderGo::ExchangeServer server{context, simulatorConfig, serverConfig, *events};
+        boost::asio::signal_set signals{context, SIGINT, SIGTERM};
+        signals.async_wait([&context](const boost::system::error_code& error, int) {
+            if (!error)
+            {
+                context.stop();
+            }
+        });
+
+        server.Start();
+        const auto runStart = std::chrono::steady_clock::now();
+        while (!server.IsFinished() && !context.stopped())
+        {
+            context.run_one();
+        }
+        const auto runEnd = std::chrono::steady_clock::now();
+
+        const auto& exchange = server.GetExchange();
+        const auto& account = exchange.GetAccount();
+        const auto& stats = exchange.GetStats();
+        std::cout << std::fixed << std::setprecision(2)
+                  << "market data:    " << filename << " (" << exchange.EventsProcessed() << " events, "
+                  << server.Ticks() << " ticks, " << server.Now() << "s)\n"
+                  << "status:         " << exchange.GetStatus() << '\n'
+                  << "profit or loss: " << account.mProfitOrLoss / 100.0 << '\n'
+                  << "max drawdown:   " << account.mMaxDrawdown / 100.0 << '\n'
+                  << "fees:           " << account.mTotalFees / 100.0 << '\n'
+                  << "etf position:   " << account.mEtfPosition << " (max " << stats.mMaxEtfPosition << ")\n"
+                  << "fut position:   " << account.mFuturePosition << '\n'
+                  << "etf volume:     " << account.mBuyVolume << " bought, " << account.mSellVolume << " sold\n"
+                  << "messages:       " << stats.mMessagesReceived << " (" << stats.mInserts << " inserts, "
+                  << stats.mAmends << " amends, " << stats.mCancels << " cancels, " << stats.mHedges << " hedges)\n"
+                  << "fills:          " << stats.mFills << '\n'
+                  << "errors:         " << stats.mErrors << '\n'
+                  << "run time:       " << std::chrono::duration<double>(runEnd - runStart).count() << 's'
+                  << std::endl;
+    }
+    catch (const boost::property_tree::ptree_error& e)
+    {
+        std::cerr << "bad configuration: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (const ReadyTraderGo::ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
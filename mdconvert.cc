@@ -0,0 +1,106 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <ready_trader_go/error.h>
+#include <simulator/marketdata.h>
+#include <simulator/marketdatafile.h>
+
+// Converts a market data CSV file to the columnar format that the backtest
+// maps instead of parsing (see libs/simulator/marketdatafile.h), then reads
+// the result back and checks that it holds the same events:
+//
+//     mdconvert market_data.csv [market_data.rtgmd]
+//
+// By default the output goes next to the input with its extension changed.
+static std::string DefaultOutput(const std::string& input)
+{
+    const auto dot = input.find_last_of('.');
+    const auto slash = input.find_last_of('/');
+    const bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (hasExtension ? input.substr(0, dot) : input) + ".rtgmd";
+}
+
+static bool SameEvent(const ReadyTraderGo::MarketEvent& a, const ReadyTraderGo::MarketEvent& b)
+{
+    // Fields the exchange ignores for an operation (such as the side of a
+    // cancel) are compared too, since they are stored just the same.
+    return a.mTime == b.mTime && a.mOrderId == b.mOrderId && a.mVolume == b.mVolume && a.mPrice == b.mPrice
+           && a.mInstrument == b.mInstrument && a.mOperation == b.mOperation && a.mSide == b.mSide
+           && a.mLifespan == b.mLifespan;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <market data csv> [output file]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string input = argv[1];
+    const std::string output = (argc > 2) ? argv[2] : DefaultOutput(input);
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto events = ReadyTraderGo::ReadMarketDataCsv(input);
+        const auto parsed = std::chrono::steady_clock::now();
+        ReadyTraderGo::WriteMarketDataFile(output, events);
+
+        const auto mapStart = std::chrono::steady_clock::now();
+        const ReadyTraderGo::MarketDataFile file{output};
+        auto cursor = file.Events();
+        const auto mapped = std::chrono::steady_clock::now();
+
+        ReadyTraderGo::MarketEvent event;
+        std::size_t count = 0;
+        while (cursor.Next(event))
+        {
+            if (count == events.size() || !SameEvent(event, events[count]))
+            {
+                std::cerr << "event " << count << " does not read back the same" << std::endl;
+                return EXIT_FAILURE;
+            }
+            ++count;
+        }
+        if (count != events.size())
+        {
+            std::cerr << "only " << count << " of " << events.size() << " events read back" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const auto milliseconds = [](auto duration) {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        };
+        std::cout << output << ": " << events.size() << " events (" << file.Size(ReadyTraderGo::Instrument::FUTURE)
+                  << " future, " << file.Size(ReadyTraderGo::Instrument::ETF) << " etf); csv parsed in "
+                  << milliseconds(parsed - start) << "ms, file mapped in " << milliseconds(mapped - mapStart) << "ms"
+                  << std::endl;
+    }
+    catch (const ReadyTraderGo::ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
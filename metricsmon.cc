@@ -0,0 +1,198 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <ready_trader_go/clock.h>
+#include <ready_trader_go/metrics.h>
+#include <ready_trader_go/protocol.h>
+
+namespace interprocess = boost::interprocess;
+using namespace ReadyTraderGo;
+
+// Prints the metrics a running autotrader publishes in shared memory. With
+// an interval, prints them again every interval along with how much each
+// counter has moved since the last time:
+//
+//     metricsmon <team name or segment name> [interval in milliseconds]
+//
+// The segment is mapped read-only, so this can't disturb the trader.
+
+static const char* MessageTypeName(std::size_t type)
+{
+    switch (type)
+    {
+    case MessageType::AMEND_ORDER: return "amend";
+    case MessageType::CANCEL_ORDER: return "cancel";
+    case MessageType::ERROR_MESSAGE: return "error";
+    case MessageType::HEDGE_FILLED: return "hedge filled";
+    case MessageType::HEDGE_ORDER: return "hedge";
+    case MessageType::INSERT_ORDER: return "insert";
+    case MessageType::LOGIN: return "login";
+    case MessageType::ORDER_BOOK_UPDATE: return "order book";
+    case MessageType::ORDER_FILLED: return "order filled";
+    case MessageType::ORDER_STATUS: return "order status";
+    case MessageType::TRADE_TICKS: return "trade ticks";
+    default: return nullptr;
+    }
+}
+
+struct Snapshot
+{
+    std::array<std::uint64_t, METRICS_MESSAGE_TYPES> mMessagesIn = {};
+    std::array<std::uint64_t, METRICS_MESSAGE_TYPES> mMessagesOut = {};
+    std::uint64_t mRingOverruns = 0;
+    std::uint64_t mSequenceGaps = 0;
+    std::uint64_t mSequenceDrops = 0;
+    std::uint64_t mLocalRejects = 0;
+    std::uint64_t mExchangeErrors = 0;
+};
+
+static Snapshot Take(const MetricsSegment& segment)
+{
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < METRICS_MESSAGE_TYPES; ++i)
+    {
+        snapshot.mMessagesIn[i] = segment.mMessagesIn[i].load(std::memory_order_relaxed);
+        snapshot.mMessagesOut[i] = segment.mMessagesOut[i].load(std::memory_order_relaxed);
+    }
+    snapshot.mRingOverruns = segment.mRingOverruns.load(std::memory_order_relaxed);
+    snapshot.mSequenceGaps = segment.mSequenceGaps.load(std::memory_order_relaxed);
+    snapshot.mSequenceDrops = segment.mSequenceDrops.load(std::memory_order_relaxed);
+    snapshot.mLocalRejects = segment.mLocalRejects.load(std::memory_order_relaxed);
+    snapshot.mExchangeErrors = segment.mExchangeErrors.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+static void PrintCounter(const char* name, std::uint64_t value, std::uint64_t previous, bool streaming)
+{
+    std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(12) << value;
+    if (streaming)
+    {
+        std::cout << "  (+" << value - previous << ")";
+    }
+    std::cout << '\n';
+}
+
+static void Print(const MetricsSegment& segment, const Snapshot& now, const Snapshot& before, bool streaming)
+{
+    const std::int64_t heartbeat = segment.mHeartbeat.load(std::memory_order_relaxed);
+    std::cout << segment.mName.data() << " (pid " << segment.mProcessId << ")";
+    if (heartbeat != 0)
+    {
+        const double age = static_cast<double>(Clock::now().time_since_epoch().count() - heartbeat) / 1e6;
+        std::cout << ", last message " << std::fixed << std::setprecision(1) << age << " ms ago";
+    }
+    std::cout << '\n';
+
+    std::cout << "messages in:\n";
+    for (std::size_t i = 0; i < METRICS_MESSAGE_TYPES; ++i)
+    {
+        if (const char* name = MessageTypeName(i); name != nullptr && now.mMessagesIn[i] != 0)
+        {
+            PrintCounter(name, now.mMessagesIn[i], before.mMessagesIn[i], streaming);
+        }
+    }
+    std::cout << "messages out:\n";
+    for (std::size_t i = 0; i < METRICS_MESSAGE_TYPES; ++i)
+    {
+        if (const char* name = MessageTypeName(i); name != nullptr && now.mMessagesOut[i] != 0)
+        {
+            PrintCounter(name, now.mMessagesOut[i], before.mMessagesOut[i], streaming);
+        }
+    }
+    std::cout << "errors:\n";
+    PrintCounter("ring overruns", now.mRingOverruns, before.mRingOverruns, streaming);
+    PrintCounter("sequence gaps", now.mSequenceGaps, before.mSequenceGaps, streaming);
+    PrintCounter("sequence drops", now.mSequenceDrops, before.mSequenceDrops, streaming);
+    PrintCounter("local rejects", now.mLocalRejects, before.mLocalRejects, streaming);
+    PrintCounter("exchange errors", now.mExchangeErrors, before.mExchangeErrors, streaming);
+    std::cout << "state:\n"
+              << "  held messages       " << std::setw(12) << segment.mHeldMessages.load(std::memory_order_relaxed) << '\n'
+              << "  rate budget         " << std::setw(12) << segment.mRateBudget.load(std::memory_order_relaxed) << '\n'
+              << "  active orders       " << std::setw(12) << segment.mActiveOrders.load(std::memory_order_relaxed) << '\n'
+              << "  etf position        " << std::setw(12) << segment.mEtfPosition.load(std::memory_order_relaxed) << '\n'
+              << "  future position     " << std::setw(12) << segment.mFuturePosition.load(std::memory_order_relaxed) << '\n'
+              << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <team name or segment name> [interval in milliseconds]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string name = argv[1];
+    const long interval = (argc > 2) ? std::strtol(argv[2], nullptr, 10) : 0;
+
+    interprocess::shared_memory_object object;
+    try
+    {
+        object = interprocess::shared_memory_object(interprocess::open_only, name.c_str(), interprocess::read_only);
+    }
+    catch (const interprocess::interprocess_exception&)
+    {
+        try
+        {
+            object = interprocess::shared_memory_object(interprocess::open_only, MetricsSegmentName(name).c_str(),
+                                                        interprocess::read_only);
+        }
+        catch (const interprocess::interprocess_exception& e)
+        {
+            std::cerr << "no metrics segment for '" << name << "': " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    interprocess::mapped_region region{object, interprocess::read_only};
+    const auto& segment = *static_cast<const MetricsSegment*>(region.get_address());
+    if (region.get_size() < sizeof(std::uint32_t) * 3 || segment.mMagic != METRICS_MAGIC)
+    {
+        std::cerr << "'" << object.get_name() << "' is not a metrics segment" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (segment.mVersion != METRICS_VERSION || segment.mSize < sizeof(MetricsSegment)
+        || region.get_size() < sizeof(MetricsSegment))
+    {
+        std::cerr << "'" << object.get_name() << "' has layout version " << segment.mVersion
+                  << " but this monitor reads version " << METRICS_VERSION << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Snapshot before = Take(segment);
+    Print(segment, before, before, false);
+    while (interval > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        const Snapshot now = Take(segment);
+        Print(segment, now, before, true);
+        before = now;
+    }
+
+    return EXIT_SUCCESS;
+}
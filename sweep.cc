@@ -0,0 +1,358 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/config.h>
+#include <ready_trader_go/error.h>
+#include <simulator/backtest.h>
+#include <simulator/marketdata.h>
+#include <simulator/marketdatafile.h>
+#include <simulator/toolsupport.h>
+
+#include "autotrader.h"
+
+// Backtests the AutoTrader over many sets of strategy parameters in
+// parallel and prints how each did, best first:
+//
+//     sweep [sweep.json] [exchange.json] [autotrader.json] [market_data.csv]
+//
+// The sweep file names the parameters to vary (see AutoTraderParameters)
+// and the values each may take, either as a list or as a range:
+//
+//     { "Search": "Grid", "Threads": 0,
+//       "Parameters": { "LotSize": [100, 150, 200],
+//                       "Unload": { "Min": 10, "Max": 40, "Step": 5 } } }
+//
+// A grid search runs every combination; a random search ("Search":
+// "Random") runs "Samples" combinations drawn uniformly, from "Seed".
+// Parameters that are not varied come from the Strategy section of the
+// autotrader configuration, if it has one, or keep their defaults. Threads
+// is the number of runs at once, or zero for one per core.
+//
+// The simulator's latencies may be varied too, in whole microseconds, as
+// "Latency.InformationPublish", "Latency.OrderEntry" and
+// "Latency.ExecutionReport"; otherwise they come from the Latency section of
+// the exchange configuration.
+//
+// Each run is an independent in-process Backtest on a thread of its own
+// for as long as it runs, since a Backtest's simulated time belongs to its
+// thread. Runs are handed out to the threads as they come free, so a slow
+// run does not hold up the rest. All of them share one copy of the market
+// data: a file made by mdconvert is mapped once, and a CSV file is read once.
+struct SweepParameter
+{
+    std::string mName;
+    std::vector<long> mValues;
+};
+
+struct SweepRun
+{
+    std::size_t mNumber = 0;
+    std::vector<long> mValues;                  // One for each SweepParameter.
+    ReadyTraderGo::BacktestResult mResult;
+    std::string mError;
+};
+
+static bool IsLatencyParameter(const std::string& name)
+{
+    return name == "Latency.InformationPublish" || name == "Latency.OrderEntry" || name == "Latency.ExecutionReport";
+}
+
+// A list of values, or a range from Min to Max (inclusive) in steps of Step.
+static SweepParameter ReadSweepParameter(const std::string& name, const boost::property_tree::ptree& tree)
+{
+    // Anything else would be silently ignored, giving identical runs.
+    if (!AutoTraderParameters::IsParameterName(name) && !IsLatencyParameter(name))
+    {
+        throw ReadyTraderGo::ReadyTraderGoError("unknown sweep parameter " + name);
+    }
+
+    SweepParameter parameter{name, {}};
+    if (tree.get_child_optional("Min"))
+    {
+        const long lowest = tree.get<long>("Min");
+        const long highest = tree.get<long>("Max");
+        const long step = tree.get<long>("Step", 1);
+        if (step <= 0 || highest < lowest)
+        {
+            throw ReadyTraderGo::ReadyTraderGoError("bad range for sweep parameter " + name);
+        }
+        for (long value = lowest; value <= highest; value += step)
+        {
+            parameter.mValues.push_back(value);
+        }
+    }
+    else if (!tree.empty())
+    {
+        for (const auto& child: tree)
+        {
+            parameter.mValues.push_back(child.second.get_value<long>());
+        }
+    }
+    else
+    {
+        parameter.mValues.push_back(tree.get_value<long>());
+    }
+
+    if (parameter.mValues.empty())
+    {
+        throw ReadyTraderGo::ReadyTraderGoError("no values for sweep parameter " + name);
+    }
+    return parameter;
+}
+
+static std::vector<SweepRun> MakeRuns(const boost::property_tree::ptree& sweepTree,
+                                      const std::vector<SweepParameter>& parameters)
+{
+    std::vector<SweepRun> runs;
+    const std::string search = sweepTree.get<std::string>("Search", "Grid");
+    if (search == "Grid")
+    {
+        // Count through the combinations with the last parameter varying
+        // fastest.
+        std::vector<std::size_t> position(parameters.size(), 0);
+        for (bool more = true; more;)
+        {
+            SweepRun& run = runs.emplace_back();
+            run.mNumber = runs.size();
+            for (std::size_t i = 0; i < parameters.size(); ++i)
+            {
+                run.mValues.push_back(parameters[i].mValues[position[i]]);
+            }
+
+            more = false;
+            for (std::size_t i = parameters.size(); i-- > 0;)
+            {
+                if (++position[i] < parameters[i].mValues.size())
+                {
+                    more = true;
+                    break;
+                }
+                position[i] = 0;
+            }
+        }
+    }
+    else if (search == "Random")
+    {
+        const std::size_t samples = sweepTree.get<std::size_t>("Samples");
+        std::mt19937_64 generator{sweepTree.get<std::uint64_t>("Seed", 1)};
+        for (std::size_t n = 0; n < samples; ++n)
+        {
+            SweepRun& run = runs.emplace_back();
+            run.mNumber = runs.size();
+            for (const SweepParameter& parameter: parameters)
+            {
+                std::uniform_int_distribution<std::size_t> pick{0, parameter.mValues.size() - 1};
+                run.mValues.push_back(parameter.mValues[pick(generator)]);
+            }
+        }
+    }
+    else
+    {
+        throw ReadyTraderGo::ReadyTraderGoError("Search must be 'Grid' or 'Random'");
+    }
+    return runs;
+}
+
+int main(int argc, char* argv[])
+{
+    boost::property_tree::ptree sweepTree;
+    boost::property_tree::ptree exchangeTree;
+    boost::property_tree::ptree traderTree;
+    if (!ReadyTraderGo::ReadJsonFile((argc > 1) ? argv[1] : "sweep.json", sweepTree)
+        || !ReadyTraderGo::ReadJsonFile((argc > 2) ? argv[2] : "exchange.json", exchangeTree)
+        || !ReadyTraderGo::ReadJsonFile((argc > 3) ? argv[3] : "autotrader.json", traderTree))
+    {
+        return EXIT_FAILURE;
+    }
+
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        ReadyTraderGo::SimulatorConfig simulatorConfig;
+        simulatorConfig.readFromPropertyTree(exchangeTree);
+        if (argc > 4)
+        {
+            simulatorConfig.mMarketDataFile = argv[4];
+        }
+
+        ReadyTraderGo::Config traderConfig;
+        traderConfig.readFromPropertyTree(traderTree);
+        const boost::property_tree::ptree strategyTree = traderTree.get_child("Strategy", {});
+
+        std::vector<SweepParameter> parameters;
+        for (const auto& child: sweepTree.get_child("Parameters"))
+        {
+            parameters.push_back(ReadSweepParameter(child.first, child.second));
+        }
+        std::vector<SweepRun> runs = MakeRuns(sweepTree, parameters);
+
+        std::size_t threads = sweepTree.get<std::size_t>("Threads", 0);
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, runs.size());
+
+        const std::string& filename = simulatorConfig.mMarketDataFile;
+        std::vector<ReadyTraderGo::MarketEvent> csvEvents;
+        std::unique_ptr<ReadyTraderGo::MarketDataFile> mappedEvents;
+        if (ReadyTraderGo::IsMarketDataCsv(filename))
+        {
+            csvEvents = ReadyTraderGo::ReadMarketDataCsv(filename);
+        }
+        else
+        {
+            mappedEvents = std::make_unique<ReadyTraderGo::MarketDataFile>(filename);
+        }
+
+        const auto runStart = std::chrono::steady_clock::now();
+        std::atomic<std::size_t> completed{0};
+        {
+            boost::asio::thread_pool pool{threads};
+            for (std::size_t n = 0; n < runs.size(); ++n)
+            {
+                boost::asio::post(pool, [&, n] {
+                    SweepRun& run = runs[n];
+                    try
+                    {
+                        boost::property_tree::ptree runTree = strategyTree;
+                        ReadyTraderGo::SimulatorConfig runConfig = simulatorConfig;
+                        for (std::size_t i = 0; i < parameters.size(); ++i)
+                        {
+                            const std::string& name = parameters[i].mName;
+                            const double microseconds = static_cast<double>(run.mValues[i]) * 1e-6;
+                            if (name == "Latency.InformationPublish")
+                            {
+                                runConfig.mInformationLatency = microseconds;
+                            }
+                            else if (name == "Latency.OrderEntry")
+                            {
+                                runConfig.mOrderEntryLatency = microseconds;
+                            }
+                            else if (name == "Latency.ExecutionReport")
+                            {
+                                runConfig.mExecutionReportLatency = microseconds;
+                            }
+                            else
+                            {
+                                runTree.put(name, run.mValues[i]);
+                            }
+                        }
+                        AutoTraderParameters runParameters;
+                        runParameters.readFromPropertyTree(runTree);
+
+                        std::unique_ptr<ReadyTraderGo::MarketEventSource> events;
+                        if (mappedEvents)
+                        {
+                            events = std::make_unique<ReadyTraderGo::MarketDataFile::Cursor>(mappedEvents->Events());
+                        }
+                        else
+                        {
+                            events = std::make_unique<ReadyTraderGo::MarketEventVectorSource>(csvEvents);
+                        }
+
+                        ReadyTraderGo::Backtest backtest{runConfig, *events};
+                        boost::asio::io_context context;
+                        AutoTrader trader{context, runParameters};
+                        trader.SetLoginDetails(traderConfig.mTeamName, traderConfig.mSecret);
+                        trader.SetExchangeLimits(traderConfig.mLimits);
+                        run.mResult = backtest.Run(trader, context);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        run.mError = e.what();
+                    }
+                    ++completed;
+                });
+            }
+            pool.join();
+        }
+        const auto runEnd = std::chrono::steady_clock::now();
+
+        std::stable_sort(runs.begin(), runs.end(), [](const SweepRun& a, const SweepRun& b) {
+            if (a.mError.empty() != b.mError.empty())
+            {
+                return a.mError.empty();
+            }
+            return a.mResult.mAccount.mProfitOrLoss > b.mResult.mAccount.mProfitOrLoss;
+        });
+
+        std::cout << std::setw(5) << "run";
+        for (const SweepParameter& parameter: parameters)
+        {
+            std::cout << ' ' << std::setw(std::max<int>(8, static_cast<int>(parameter.mName.size()))) << parameter.mName;
+        }
+        std::cout << ' ' << std::setw(12) << "pnl" << ' ' << std::setw(10) << "fees" << ' ' << std::setw(8)
+                  << "messages" << ' ' << std::setw(7) << "max pos" << "  status\n";
+
+        std::cout << std::fixed << std::setprecision(2);
+        for (const SweepRun& run: runs)
+        {
+            std::cout << std::setw(5) << run.mNumber;
+            for (std::size_t i = 0; i < parameters.size(); ++i)
+            {
+                std::cout << ' ' << std::setw(std::max<int>(8, static_cast<int>(parameters[i].mName.size())))
+                          << run.mValues[i];
+            }
+            if (!run.mError.empty())
+            {
+                std::cout << "  " << run.mError << '\n';
+                continue;
+            }
+            const auto& account = run.mResult.mAccount;
+            const auto& stats = run.mResult.mStats;
+            std::cout << ' ' << std::setw(12) << account.mProfitOrLoss / 100.0 << ' ' << std::setw(10)
+                      << account.mTotalFees / 100.0 << ' ' << std::setw(8) << stats.mMessagesReceived << ' '
+                      << std::setw(7) << stats.mMaxEtfPosition << "  " << run.mResult.mStatus << '\n';
+        }
+
+        std::cerr << completed << " runs on " << threads << " threads in "
+                  << std::chrono::duration<double>(runEnd - runStart).count() << 's' << std::endl;
+    }
+    catch (const boost::property_tree::ptree_error& e)
+    {
+        std::cerr << "bad configuration: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (const ReadyTraderGo::ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}